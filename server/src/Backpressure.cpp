@@ -0,0 +1,28 @@
+#include "Backpressure.hpp"
+
+bool Backpressure::admit(OutboundState& state, size_t buffered, size_t size, clock::time_point now) const {
+    if (state.stale) {
+        return false;
+    }
+    if (buffered > 0 && buffered + size > m_limit) {
+        state.stale = true;
+        state.over_limit_since = now;
+        return false;
+    }
+    return true;
+}
+
+Backpressure::Action Backpressure::poll(OutboundState& state, size_t buffered, clock::time_point now) const {
+    if (!state.stale || state.disconnecting) {
+        return Action::None;
+    }
+    if (buffered <= m_limit / 2) {
+        state.stale = false;
+        return Action::Resync;
+    }
+    if (now - state.over_limit_since >= m_timeout) {
+        state.disconnecting = true;
+        return Action::Disconnect;
+    }
+    return Action::None;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+/// Outbound flow control state of one connection
+struct OutboundState {
+    // An update was dropped, the next thing sent must be a full snapshot
+    bool stale = false;
+    // Disconnect was already requested
+    bool disconnecting = false;
+    std::chrono::steady_clock::time_point over_limit_since;
+};
+
+/// Decides what happens to state updates for connections whose socket
+/// buffer is backing up. Instead of queuing more deltas behind a stalled
+/// client, updates are dropped and the connection is marked stale; once the
+/// buffer drains a single snapshot replaces everything that was skipped. A
+/// connection that stays over the limit for too long is disconnected.
+class Backpressure {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    enum class Action {
+        None,
+        Resync,
+        Disconnect
+    };
+
+    Backpressure(size_t limit, clock::duration timeout) : m_limit(limit), m_timeout(timeout) {}
+
+    // Whether an update of `size` bytes may be queued on a connection that
+    // already has `buffered` bytes pending. An idle connection always accepts
+    // one message so snapshots larger than the limit still get through.
+    bool admit(OutboundState& state, size_t buffered, size_t size, clock::time_point now) const;
+
+    // Periodic check for stale connections: resync once the buffer has
+    // drained below half the limit, disconnect after the timeout.
+    Action poll(OutboundState& state, size_t buffered, clock::time_point now) const;
+
+    size_t limit() const { return m_limit; }
+
+private:
+    size_t m_limit;
+    clock::duration m_timeout;
+};
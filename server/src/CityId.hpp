@@ -0,0 +1,10 @@
+#ifndef CITYID_HPP
+#define CITYID_HPP
+
+/// Dense index of a city on the board. Names are interned to ids when the
+/// map is built and only translated back at the JSON boundary.
+typedef int CityId;
+
+const CityId INVALID_CITY = -1;
+
+#endif // CITYID_HPP
@@ -0,0 +1,15 @@
+#include "GameAction.hpp"
+#include <cstddef>
+
+namespace {
+    // Indexed by GameAction::Type
+    const char* const ACTION_NAMES[] = {"place_tile", "place_link", "take_loan", "develop", "scout", "sell", "unknown"};
+
+    static_assert(sizeof(ACTION_NAMES) / sizeof(ACTION_NAMES[0]) == static_cast<size_t>(GameAction::Type::Unknown) + 1,
+                  "one name per action type");
+}
+
+const char* toString(GameAction::Type type) {
+    size_t index = static_cast<size_t>(type);
+    return index < sizeof(ACTION_NAMES) / sizeof(ACTION_NAMES[0]) ? ACTION_NAMES[index] : "unknown";
+}
@@ -1,5 +1,5 @@
 #pragma once
-#include <string>
+#include "CityId.hpp"
 #include "Tile.hpp"
 
 struct GameAction {
@@ -14,12 +14,16 @@ struct GameAction {
     };
 
     Type type;
-    std::string cityName;
-    std::string cityName2;
+    CityId city;
+    CityId city2;
     TileType tileType;
     TileType tileType2;
     int slotIndex;
     
 
-    GameAction() : type(Type::Unknown), slotIndex(-1) {}
+    GameAction() : type(Type::Unknown), city(INVALID_CITY), city2(INVALID_CITY), tileType(TileType::NullTile),
+                   tileType2(TileType::NullTile), slotIndex(-1) {}
 };
+
+// Name of an action type as used in logs, metrics and reports, e.g. "place_tile"
+const char* toString(GameAction::Type type);
@@ -2,7 +2,7 @@
 #include "Tile.hpp"
 #include "Player.hpp"
 #include <algorithm>
-#include <queue>
+#include <cassert>
 #include <set>
 #include <memory>
 #include <stdexcept>
@@ -30,109 +30,299 @@ namespace
         }
     }
 
-    bool canSellTile(const std::set<MerchantType> &connectedMerchantTypes, const TileType tileType)
+    unsigned merchantTypeBit(MerchantType type)
     {
-        MerchantType requiredType = getTileRequiredMerchantType(tileType);
-        return connectedMerchantTypes.count(requiredType) > 0 ||
-               connectedMerchantTypes.count(MerchantType::Any) > 0;
+        return 1u << static_cast<unsigned>(type);
     }
 }
 
-int GameBoard::getAvailableBeerFromMerchantSlots(const std::string &cityName, const MerchantType &allowedType) const
+CityId GameBoard::internCity(const std::string &name)
 {
-    int beer = 0;
-    for (const auto *merchantCity : getConnectedMerchantCities(cityName))
+    auto it = layout->cityIds.find(name);
+    if (it != layout->cityIds.end())
+        return it->second;
+    MapLayout &map = editLayout();
+    CityId id = static_cast<CityId>(map.cityNames.size());
+    map.cityIds.emplace(name, id);
+    map.cityNames.push_back(name);
+    City city(id, name);
+    city.firstSlot = static_cast<int>(slotTiles.size());
+    map.cities.push_back(city);
+    rebuildAdjacency();
+    rebuildComponents();
+    rebuildNetworks();
+    return id;
+}
+
+void GameBoard::rebuildAdjacency()
+{
+    MapLayout &map = editLayout();
+    std::vector<int> &offsets = map.adjacencyOffsets;
+    offsets.assign(map.cityNames.size() + 1, 0);
+    for (const auto &connection : connections)
     {
-        for (const auto &slot : merchantCity->slots)
-        {
-            if (slot.placedTile && slot.placedTile->type == TileType::Merchant)
-            {
-                const MerchantTile *merchantTile = dynamic_cast<const MerchantTile *>(slot.placedTile.get());
-                if (merchantTile->merchantType == allowedType || merchantTile->merchantType == MerchantType::Any)
-                {
+        offsets[connection.city1 + 1]++;
+        offsets[connection.city2 + 1]++;
+    }
+    for (size_t i = 1; i < offsets.size(); i++)
+    {
+        offsets[i] += offsets[i - 1];
+    }
 
-                    beer += merchantTile->resource_amount;
-                }
-            }
-        }
+    map.adjacentCities.resize(connections.size() * 2);
+    map.adjacentConnections.resize(connections.size() * 2);
+    std::vector<int> next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < connections.size(); i++)
+    {
+        const Connection &connection = connections[i];
+        map.adjacentCities[next[connection.city1]] = connection.city2;
+        map.adjacentConnections[next[connection.city1]++] = static_cast<int>(i);
+        map.adjacentCities[next[connection.city2]] = connection.city1;
+        map.adjacentConnections[next[connection.city2]++] = static_cast<int>(i);
     }
-    return beer;
 }
 
-int GameBoard::getAvailableBeerFromBreweries(const std::string &cityName, const Player &player) const
+void GameBoard::rebuildComponents()
 {
-    int beer = 0;
-    std::vector<std::string> connectedCities = getConnectedCities(cityName);
-    connectedCities.push_back(cityName); // Include the city itself
+    const std::vector<City> &cities = layout->cities;
+    components.resize(cities.size());
+    for (size_t i = 0; i < cities.size(); i++)
+    {
+        CityId city = static_cast<CityId>(i);
+        CityId merchant = cities[i].merchant ? city : -1;
+        components[i] = {static_cast<int>(i), -1, -1, city, merchant, merchant, 1};
+    }
+    for (const auto &connection : connections)
+    {
+        if (connection.hasLink())
+            mergeComponents(connection.city1, connection.city2);
+    }
+    discardUndoLog();
+}
 
-    for (const auto &city : connectedCities)
+void GameBoard::mergeComponents(CityId city1, CityId city2)
+{
+    int keep = components[city1].component;
+    int drop = components[city2].component;
+    if (keep == drop)
+        return;
+    if (components[keep].cityCount < components[drop].cityCount)
+        std::swap(keep, drop);
+    ComponentNode &kept = components[keep];
+    const ComponentNode &dropped = components[drop];
+    logUndo(UndoEntry::ComponentsMerged, keep, drop, kept.lastCity, kept.lastMerchant);
+
+    // The dropped component's own fields are left as they are for undo
+    for (CityId city = drop; city >= 0; city = components[city].nextCity)
+        components[city].component = keep;
+    components[kept.lastCity].nextCity = drop;
+    kept.lastCity = dropped.lastCity;
+    kept.cityCount += dropped.cityCount;
+    if (dropped.firstMerchant >= 0)
     {
-        const City *cityPtr = getCity(city);
-        if (!cityPtr)
-            continue;
+        if (kept.lastMerchant >= 0)
+            components[kept.lastMerchant].nextMerchant = dropped.firstMerchant;
+        else
+            kept.firstMerchant = dropped.firstMerchant;
+        kept.lastMerchant = dropped.lastMerchant;
+    }
+}
 
-        for (const auto &slot : cityPtr->slots)
+void GameBoard::rebuildNetworks()
+{
+    networkOwners.clear();
+    networkCities.clear();
+    for (const auto &city : layout->cities)
+    {
+        for (size_t i = 0; i < city.slots.size(); i++)
         {
-            if (slot.placedTile && slot.placedTile->type == TileType::Brewery &&
-                (slot.placedTile->owner == player.id || isCityInPlayerNetwork(player, city)))
-            {
-                beer += slot.placedTile->resource_amount;
-            }
+            TileHandle handle = slotTiles[city.firstSlot + i];
+            if (handle)
+                addToNetwork(getTile(handle).owner, city.id);
+        }
+    }
+    for (const auto &connection : connections)
+    {
+        if (connection.hasLink())
+        {
+            addToNetwork(connection.linkOwner, connection.city1);
+            addToNetwork(connection.linkOwner, connection.city2);
         }
     }
-    return beer;
+    discardUndoLog();
 }
 
-bool GameBoard::hasEnoughBeer(const std::string &cityName, const Player &player, int beerDemand, const MerchantType &allowedType) const
+int GameBoard::networkRow(int playerId) const
 {
-    // This does not work same every time
-    int availableBeer = getAvailableBeerFromMerchantSlots(cityName, allowedType) +
-                        getAvailableBeerFromBreweries(cityName, player);
-    return availableBeer >= beerDemand;
+    for (size_t row = 0; row < networkOwners.size(); row++)
+    {
+        if (networkOwners[row].playerId == playerId)
+            return static_cast<int>(row);
+    }
+    return -1;
 }
 
-City *GameBoard::addCity(const std::string &name)
+void GameBoard::addToNetwork(int playerId, CityId city)
 {
-    auto city = std::make_unique<City>(name);
-    auto *cityPtr = city.get();
-    cities[name] = std::move(city);
-    return cityPtr;
+    int row = networkRow(playerId);
+    if (row < 0)
+    {
+        row = static_cast<int>(networkOwners.size());
+        networkOwners.push_back({playerId, 0});
+        networkCities.resize(networkOwners.size() * getCityCount(), false);
+    }
+    size_t flag = row * getCityCount() + city;
+    if (!networkCities[flag])
+    {
+        networkCities[flag] = true;
+        networkOwners[row].cityCount++;
+        logUndo(UndoEntry::NetworkGrew, playerId, city);
+    }
 }
 
-MerchantCity *GameBoard::addMerchantCity(const std::string &name, MerchantBonus mb)
+int GameBoard::resourceKind(TileType type)
 {
-    auto city = std::make_unique<MerchantCity>(name, mb);
-    auto *cityPtr = city.get();
-    cities[name] = std::move(city);
-    return cityPtr;
+    switch (type)
+    {
+    case TileType::Coal:
+        return 0;
+    case TileType::Iron:
+        return 1;
+    case TileType::Brewery:
+        return 2;
+    case TileType::Merchant:
+        return 3;
+    default:
+        return -1;
+    }
 }
 
-Connection &GameBoard::addConnection(const std::string &city1, const std::string &city2)
+void GameBoard::rebuildResources()
 {
-    auto conn = connections.insert(Connection(city1, city2));
-    return const_cast<Connection &>(*conn.first);
+    for (int kind = 0; kind < RESOURCE_KINDS; kind++)
+    {
+        resourceSlots[kind].clear();
+        resourceTotals[kind] = 0;
+    }
+    for (const auto &city : layout->cities)
+    {
+        for (size_t i = 0; i < city.slots.size(); i++)
+            indexResources(city.id, static_cast<int>(i));
+    }
+    discardUndoLog();
 }
 
-void GameBoard::addSlot(const std::string &cityName, const Slot &slot)
+void GameBoard::indexResources(CityId city, int slotIndex)
 {
-    cities[cityName]->slots.push_back(slot);
+    const Tile *tile = getPlacedTile(city, slotIndex);
+    if (!tile || tile->resource_amount <= 0)
+        return;
+    int kind = resourceKind(tile->type);
+    if (kind < 0)
+        return;
+    resourceSlots[kind].push_back({city, slotIndex});
+    resourceTotals[kind] += tile->resource_amount;
+    logUndo(UndoEntry::ResourceIndexed, kind);
 }
 
-std::vector<std::string> GameBoard::getConnections(const std::string &cityName) const
+int GameBoard::findConnection(CityId city1, CityId city2) const
 {
-    std::vector<std::string> connectedCities;
-    for (const auto &connection : connections)
+    if (city1 < 0 || city1 >= static_cast<CityId>(getCityCount()))
+        return -1;
+    const MapLayout &map = *layout;
+    for (int i = map.adjacencyOffsets[city1]; i < map.adjacencyOffsets[city1 + 1]; i++)
     {
-        if (connection.city1 == cityName)
-        {
-            connectedCities.push_back(connection.city2);
-        }
-        else if (connection.city2 == cityName)
-        {
-            connectedCities.push_back(connection.city1);
-        }
+        if (map.adjacentCities[i] == city2)
+            return map.adjacentConnections[i];
     }
-    return connectedCities;
+    return -1;
+}
+
+CityId GameBoard::addCity(const std::string &name)
+{
+    CityId id = internCity(name);
+    defineCity(id, false, MerchantBonus::Income2);
+    return id;
+}
+
+CityId GameBoard::addMerchantCity(const std::string &name, MerchantBonus mb)
+{
+    CityId id = internCity(name);
+    defineCity(id, true, mb);
+    return id;
+}
+
+void GameBoard::defineCity(CityId id, bool merchant, MerchantBonus mb)
+{
+    MapLayout &map = editLayout();
+    City &city = map.cities[id];
+    // Defining a city again starts it over without slots
+    int removed = static_cast<int>(city.slots.size());
+    slotTiles.erase(slotTiles.begin() + city.firstSlot, slotTiles.begin() + city.firstSlot + removed);
+    for (size_t i = id + 1; i < map.cities.size(); i++)
+        map.cities[i].firstSlot -= removed;
+    city.slots.clear();
+    city.defined = true;
+    city.merchant = merchant;
+    city.merchant_bonus = mb;
+    rebuildComponents();
+    rebuildNetworks();
+    rebuildResources();
+}
+
+Connection &GameBoard::addConnection(const std::string &city1, const std::string &city2)
+{
+    CityId id1 = internCity(city1);
+    CityId id2 = internCity(city2);
+    Connection connection(id1, id2);
+    auto it = std::lower_bound(connections.begin(), connections.end(), connection);
+    if (it != connections.end() && !(connection < *it))
+        return *it;
+    it = connections.insert(it, connection);
+    rebuildAdjacency();
+    // Logged connection indices after this one have shifted
+    discardUndoLog();
+    return *it;
+}
+
+void GameBoard::addSlot(const std::string &cityName, const Slot &slot)
+{
+    addSlot(getCityId(cityName), slot);
+}
+
+void GameBoard::addSlot(CityId city, const Slot &slot)
+{
+    if (!getCity(city))
+        throw std::out_of_range("addSlot: unknown city");
+    MapLayout &map = editLayout();
+    City &target = map.cities[city];
+    slotTiles.insert(slotTiles.begin() + target.firstSlot + target.slots.size(), TileHandle());
+    target.slots.push_back(slot);
+    for (size_t i = city + 1; i < map.cities.size(); i++)
+        map.cities[i].firstSlot++;
+}
+
+CityId GameBoard::getCityId(const std::string &cityName) const
+{
+    auto it = layout->cityIds.find(cityName);
+    return it != layout->cityIds.end() ? it->second : INVALID_CITY;
+}
+
+const std::string &GameBoard::getCityName(CityId city) const
+{
+    static const std::string UNKNOWN;
+    if (city < 0 || city >= static_cast<CityId>(getCityCount()))
+        return UNKNOWN;
+    return layout->cityNames[city];
+}
+
+std::vector<CityId> GameBoard::getConnections(CityId city) const
+{
+    if (city < 0 || city >= static_cast<CityId>(getCityCount()))
+        return {};
+    const MapLayout &map = *layout;
+    return std::vector<CityId>(map.adjacentCities.begin() + map.adjacencyOffsets[city],
+                               map.adjacentCities.begin() + map.adjacencyOffsets[city + 1]);
 }
 
 void GameBoard::initializeBrassBirminghamMap()
@@ -196,87 +386,87 @@ void GameBoard::initializeBrassBirminghamMap()
     addConnection("Belper", "Leek");
 
     // Add slots
-    addSlot("Birmingham", {{TileType::Manufacturer, TileType::Cotton}, nullptr});
-    addSlot("Birmingham", {{TileType::Manufacturer}, nullptr});
-    addSlot("Birmingham", {{TileType::Iron}, nullptr});
-    addSlot("Birmingham", {{TileType::Manufacturer}, nullptr});
+    addSlot("Birmingham", {{TileType::Manufacturer, TileType::Cotton}});
+    addSlot("Birmingham", {{TileType::Manufacturer}});
+    addSlot("Birmingham", {{TileType::Iron}});
+    addSlot("Birmingham", {{TileType::Manufacturer}});
 
-    addSlot("Coventry", {{TileType::Pottery}, nullptr});
-    addSlot("Coventry", {{TileType::Manufacturer, TileType::Coal}, nullptr});
-    addSlot("Coventry", {{TileType::Iron, TileType::Manufacturer}, nullptr});
+    addSlot("Coventry", {{TileType::Pottery}});
+    addSlot("Coventry", {{TileType::Manufacturer, TileType::Coal}});
+    addSlot("Coventry", {{TileType::Iron, TileType::Manufacturer}});
 
-    addSlot("Nuneaton", {{TileType::Coal, TileType::Cotton}, nullptr});
-    addSlot("Nuneaton", {{TileType::Manufacturer, TileType::Brewery}, nullptr});
+    addSlot("Nuneaton", {{TileType::Coal, TileType::Cotton}});
+    addSlot("Nuneaton", {{TileType::Manufacturer, TileType::Brewery}});
 
-    addSlot("Redditch", {{TileType::Manufacturer, TileType::Coal}, nullptr});
-    addSlot("Redditch", {{TileType::Iron}, nullptr});
+    addSlot("Redditch", {{TileType::Manufacturer, TileType::Coal}});
+    addSlot("Redditch", {{TileType::Iron}});
 
-    addSlot("Worcester", {{TileType::Cotton}, nullptr});
-    addSlot("Worcester", {{TileType::Cotton}, nullptr});
+    addSlot("Worcester", {{TileType::Cotton}});
+    addSlot("Worcester", {{TileType::Cotton}});
 
-    addSlot("Kidderminster", {{TileType::Cotton, TileType::Coal}, nullptr});
-    addSlot("Kidderminster", {{TileType::Cotton}, nullptr});
+    addSlot("Kidderminster", {{TileType::Cotton, TileType::Coal}});
+    addSlot("Kidderminster", {{TileType::Cotton}});
 
-    addSlot("Dudley", {{TileType::Coal}, nullptr});
-    addSlot("Dudley", {{TileType::Iron}, nullptr});
+    addSlot("Dudley", {{TileType::Coal}});
+    addSlot("Dudley", {{TileType::Iron}});
 
-    addSlot("Coalbrookdale", {{TileType::Iron, TileType::Brewery}, nullptr});
-    addSlot("Coalbrookdale", {{TileType::Iron}, nullptr});
-    addSlot("Coalbrookdale", {{TileType::Coal}, nullptr});
+    addSlot("Coalbrookdale", {{TileType::Iron, TileType::Brewery}});
+    addSlot("Coalbrookdale", {{TileType::Iron}});
+    addSlot("Coalbrookdale", {{TileType::Coal}});
 
-    addSlot("Wolverhampton", {{TileType::Manufacturer}, nullptr});
-    addSlot("Wolverhampton", {{TileType::Manufacturer, TileType::Coal}, nullptr});
+    addSlot("Wolverhampton", {{TileType::Manufacturer}});
+    addSlot("Wolverhampton", {{TileType::Manufacturer, TileType::Coal}});
 
-    addSlot("Walsall", {{TileType::Iron, TileType::Manufacturer}, nullptr});
-    addSlot("Walsall", {{TileType::Manufacturer, TileType::Brewery}, nullptr});
+    addSlot("Walsall", {{TileType::Iron, TileType::Manufacturer}});
+    addSlot("Walsall", {{TileType::Manufacturer, TileType::Brewery}});
 
-    addSlot("Tamworth", {{TileType::Cotton, TileType::Coal}, nullptr});
-    addSlot("Tamworth", {{TileType::Cotton, TileType::Coal}, nullptr});
+    addSlot("Tamworth", {{TileType::Cotton, TileType::Coal}});
+    addSlot("Tamworth", {{TileType::Cotton, TileType::Coal}});
 
-    addSlot("Cannock", {{TileType::Manufacturer, TileType::Coal}, nullptr});
-    addSlot("Cannock", {{TileType::Coal}, nullptr});
+    addSlot("Cannock", {{TileType::Manufacturer, TileType::Coal}});
+    addSlot("Cannock", {{TileType::Coal}});
 
-    addSlot("Burton-on-Trent", {{TileType::Manufacturer, TileType::Coal}, nullptr});
-    addSlot("Burton-on-Trent", {{TileType::Pottery}, nullptr});
+    addSlot("Burton-on-Trent", {{TileType::Manufacturer, TileType::Coal}});
+    addSlot("Burton-on-Trent", {{TileType::Pottery}});
 
-    addSlot("Stafford", {{TileType::Manufacturer, TileType::Brewery}, nullptr});
-    addSlot("Stafford", {{TileType::Coal}, nullptr});
+    addSlot("Stafford", {{TileType::Manufacturer, TileType::Brewery}});
+    addSlot("Stafford", {{TileType::Coal}});
 
-    addSlot("Stone", {{TileType::Cotton, TileType::Brewery}, nullptr});
-    addSlot("Stone", {{TileType::Manufacturer, TileType::Coal}, nullptr});
+    addSlot("Stone", {{TileType::Cotton, TileType::Brewery}});
+    addSlot("Stone", {{TileType::Manufacturer, TileType::Coal}});
 
-    addSlot("Uttoxeter", {{TileType::Manufacturer, TileType::Brewery}, nullptr});
-    addSlot("Uttoxeter", {{TileType::Cotton, TileType::Brewery}, nullptr});
+    addSlot("Uttoxeter", {{TileType::Manufacturer, TileType::Brewery}});
+    addSlot("Uttoxeter", {{TileType::Cotton, TileType::Brewery}});
 
-    addSlot("Stoke-on-Trent", {{TileType::Cotton, TileType::Manufacturer}, nullptr});
-    addSlot("Stoke-on-Trent", {{TileType::Pottery, TileType::Iron}, nullptr});
-    addSlot("Stoke-on-Trent", {{TileType::Manufacturer}, nullptr});
+    addSlot("Stoke-on-Trent", {{TileType::Cotton, TileType::Manufacturer}});
+    addSlot("Stoke-on-Trent", {{TileType::Pottery, TileType::Iron}});
+    addSlot("Stoke-on-Trent", {{TileType::Manufacturer}});
 
-    addSlot("Leek", {{TileType::Cotton, TileType::Manufacturer}, nullptr});
-    addSlot("Leek", {{TileType::Cotton, TileType::Coal}, nullptr});
+    addSlot("Leek", {{TileType::Cotton, TileType::Manufacturer}});
+    addSlot("Leek", {{TileType::Cotton, TileType::Coal}});
 
-    addSlot("Derby", {{TileType::Cotton, TileType::Brewery}, nullptr});
-    addSlot("Derby", {{TileType::Cotton, TileType::Manufacturer}, nullptr});
-    addSlot("Derby", {{TileType::Iron}, nullptr});
+    addSlot("Derby", {{TileType::Cotton, TileType::Brewery}});
+    addSlot("Derby", {{TileType::Cotton, TileType::Manufacturer}});
+    addSlot("Derby", {{TileType::Iron}});
 
-    addSlot("Belper", {{TileType::Cotton, TileType::Brewery}, nullptr});
-    addSlot("Belper", {{TileType::Coal}, nullptr});
-    addSlot("Belper", {{TileType::Pottery}, nullptr});
+    addSlot("Belper", {{TileType::Cotton, TileType::Brewery}});
+    addSlot("Belper", {{TileType::Coal}});
+    addSlot("Belper", {{TileType::Pottery}});
 
     // Merhcant cities slots
-    addSlot("Oxford", {{TileType::Merchant}, nullptr});
-    addSlot("Oxford", {{TileType::Merchant}, nullptr});
+    addSlot("Oxford", {{TileType::Merchant}});
+    addSlot("Oxford", {{TileType::Merchant}});
 
-    addSlot("Gloucester", {{TileType::Merchant}, nullptr});
-    addSlot("Gloucester", {{TileType::Merchant}, nullptr});
+    addSlot("Gloucester", {{TileType::Merchant}});
+    addSlot("Gloucester", {{TileType::Merchant}});
 
-    addSlot("Shrewsbury", {{TileType::Merchant}, nullptr});
+    addSlot("Shrewsbury", {{TileType::Merchant}});
 
-    addSlot("Nottingham", {{TileType::Merchant}, nullptr});
-    addSlot("Nottingham", {{TileType::Merchant}, nullptr});
+    addSlot("Nottingham", {{TileType::Merchant}});
+    addSlot("Nottingham", {{TileType::Merchant}});
 
-    addSlot("Warrington", {{TileType::Merchant}, nullptr});
-    addSlot("Warrington", {{TileType::Merchant}, nullptr});
+    addSlot("Warrington", {{TileType::Merchant}});
+    addSlot("Warrington", {{TileType::Merchant}});
 }
 
 std::vector<Connection> GameBoard::getPlacedLinks() const
@@ -284,64 +474,83 @@ std::vector<Connection> GameBoard::getPlacedLinks() const
     std::vector<Connection> placedConnections;
     std::copy_if(connections.begin(), connections.end(), std::back_inserter(placedConnections),
                  [](const Connection &connection)
-                 { return connection.linkOwner != nullptr; });
+                 { return connection.hasLink(); });
     return placedConnections;
 }
 
-bool GameBoard::placeLink(const std::string &city1, const std::string &city2, std::shared_ptr<Player> player)
+bool GameBoard::placeLink(CityId city1, CityId city2, int playerId)
 {
-    auto it = connections.find(Connection(city1, city2));
-    if (it != connections.end() && it->linkOwner == nullptr)
+    int index = findConnection(city1, city2);
+    if (playerId >= 0 && index >= 0 && !connections[index].hasLink())
     {
-        Connection updatedConnection = *it;
-        updatedConnection.linkOwner = player;
-        connections.erase(it);
-        connections.insert(std::move(updatedConnection));
+        connections[index].linkOwner = playerId;
+        logUndo(UndoEntry::LinkPlaced, index);
+        mergeComponents(city1, city2);
+        addToNetwork(playerId, city1);
+        addToNetwork(playerId, city2);
         return true;
     }
     return false;
 }
 
-std::vector<std::string> GameBoard::getConnectedCities(const std::string &startCity) const
+void GameBoard::clearLinks()
+{
+    for (auto &connection : connections)
+    {
+        connection.linkOwner = -1;
+    }
+    rebuildComponents();
+    rebuildNetworks();
+}
+
+bool GameBoard::areConnected(CityId city1, CityId city2) const
 {
-    std::vector<std::string> connectedCities;
-    std::set<std::string> visited;
-    std::queue<std::string> queue;
+    int component = getComponent(city1);
+    return component >= 0 && component == getComponent(city2);
+}
 
-    visited.insert(startCity);
-    queue.push(startCity);
+int GameBoard::getComponent(CityId city) const
+{
+    if (city < 0 || city >= static_cast<CityId>(components.size()))
+        return -1;
+    return components[city].component;
+}
 
-    while (!queue.empty())
-    {
-        std::string currentCity = queue.front();
-        queue.pop();
-        connectedCities.push_back(currentCity);
+std::vector<CityId> GameBoard::getComponentCities(int component) const
+{
+    std::vector<CityId> cities;
+    if (component < 0 || component >= static_cast<int>(components.size()) || components[component].component != component)
+        return cities;
+    cities.reserve(components[component].cityCount);
+    for (CityId city = component; city >= 0; city = components[city].nextCity)
+        cities.push_back(city);
+    return cities;
+}
 
-        // std::cout << "Start city" << currentCity << std::endl;
-        for (const auto &connection : connections)
+std::vector<CityId> GameBoard::getConnectedCities(CityId startCity) const
+{
+    std::vector<CityId> connectedCities;
+    if (startCity < 0 || startCity >= static_cast<CityId>(getCityCount()))
+        return connectedCities;
+    const MapLayout &map = *layout;
+    std::vector<bool> visited(getCityCount(), false);
+
+    // The result doubles as the BFS queue
+    visited[startCity] = true;
+    connectedCities.push_back(startCity);
+    for (size_t head = 0; head < connectedCities.size(); head++)
+    {
+        CityId currentCity = connectedCities[head];
+        for (int i = map.adjacencyOffsets[currentCity]; i < map.adjacencyOffsets[currentCity + 1]; i++)
         {
-            if (connection.linkOwner == nullptr)
+            if (!connections[map.adjacentConnections[i]].hasLink())
                 continue; // Skip if no link is placed
 
-            std::string nextCity;
-            if (connection.city1 == currentCity)
-            {
-                nextCity = connection.city2;
-            }
-            else if (connection.city2 == currentCity)
-            {
-                nextCity = connection.city1;
-            }
-            else
-            {
-                continue; // This connection doesn't involve the current city
-            }
-
-            // std::cout << "Connected" << nextCity << std::endl;
-            if (visited.find(nextCity) == visited.end())
+            CityId nextCity = map.adjacentCities[i];
+            if (!visited[nextCity])
             {
-                visited.insert(nextCity);
-                queue.push(nextCity);
+                visited[nextCity] = true;
+                connectedCities.push_back(nextCity);
             }
         }
     }
@@ -349,226 +558,347 @@ std::vector<std::string> GameBoard::getConnectedCities(const std::string &startC
     return connectedCities;
 }
 
-int GameBoard::getTotalResourceCoal(const std::string &startCity) const
+int GameBoard::getTotalResourceCoal(CityId startCity) const
 {
     int totalCoal = 0;
-    std::vector<std::string> connectedCities = getConnectedCities(startCity);
-
-    for (const auto &cityName : connectedCities)
+    for (const auto &source : getResourceSlots(TileType::Coal))
     {
-        const auto &city = cities.at(cityName);
-        for (const auto &slot : city->slots)
-        {
-            if (slot.placedTile && slot.placedTile->type == TileType::Coal)
-            {
-                totalCoal += slot.placedTile->resource_amount;
-            }
-        }
+        if (areConnected(startCity, source.city))
+            totalCoal += getPlacedTile(source.city, source.slotIndex)->resource_amount;
     }
     return totalCoal;
 }
 
 int GameBoard::getTotalResourceIron() const
 {
-    int totalIron = 0;
-    for (const auto &[cityName, city] : cities)
+    return getResourceTotal(TileType::Iron);
+}
+
+const std::vector<ResourceSlot> &GameBoard::getResourceSlots(TileType type) const
+{
+    static const std::vector<ResourceSlot> NONE;
+    int kind = resourceKind(type);
+    return kind < 0 ? NONE : resourceSlots[kind];
+}
+
+int GameBoard::getResourceTotal(TileType type) const
+{
+    int kind = resourceKind(type);
+    return kind < 0 ? 0 : resourceTotals[kind];
+}
+
+int GameBoard::consumeResource(CityId city, int slotIndex, int amount)
+{
+    int index = placedTileIndex(city, slotIndex);
+    Tile *tile = index >= 0 ? &tiles[index] : nullptr;
+    int kind = tile ? resourceKind(tile->type) : -1;
+    if (kind < 0 || amount <= 0 || tile->resource_amount <= 0)
+        return 0;
+
+    int taken = std::min(amount, tile->resource_amount);
+    tile->resource_amount -= taken;
+    resourceTotals[kind] -= taken;
+    int position = -1;
+    if (tile->resource_amount == 0)
     {
-        for (const auto &slot : city->slots)
+        auto &slots = resourceSlots[kind];
+        auto it = std::find_if(slots.begin(), slots.end(), [&](const ResourceSlot &source)
+                               { return source.city == city && source.slotIndex == slotIndex; });
+        if (it != slots.end())
         {
-            if (slot.placedTile && slot.placedTile->type == TileType::Iron)
-            {
-                totalIron += slot.placedTile->resource_amount;
-            }
+            position = static_cast<int>(it - slots.begin());
+            slots.erase(it);
         }
     }
-    return totalIron;
+    logUndo(UndoEntry::ResourceTaken, city, slotIndex, taken, position);
+    return taken;
 }
 
-bool GameBoard::canPlaceTile(const std::string &cityName, int slotIndex, const Tile &tile) const
+bool GameBoard::canPlaceTile(CityId cityId, int slotIndex, const Tile &tile) const
 {
-    auto cityIt = cities.find(cityName);
-    if (cityIt == cities.end())
+    const City *city = getCity(cityId);
+    if (!city)
         return false;
-    const auto &city = cityIt->second;
     if (slotIndex < 0 || slotIndex >= static_cast<int>(city->slots.size()))
         return false;
-    const auto &slot = city->slots[slotIndex];
-    if (slot.placedTile)
+    if (slotTiles[city->firstSlot + slotIndex])
         return false;
+    const auto &slot = city->slots[slotIndex];
     return std::find(slot.allowedTileTypes.begin(), slot.allowedTileTypes.end(), tile.type) != slot.allowedTileTypes.end();
 }
 
-bool GameBoard::placeTile(const std::string &cityName, int slotIndex, const Tile &tile)
+bool GameBoard::placeTile(CityId city, int slotIndex, const Tile &tile)
 {
-    if (!canPlaceTile(cityName, slotIndex, tile))
+    if (!canPlaceTile(city, slotIndex, tile))
         return false;
-    auto &slot = cities[cityName]->slots[slotIndex];
-    slot.placedTile = tile.clone(); // Use the clone method instead of direct copying
+    slotTiles[slotPosition(city, slotIndex)] = TileHandle(static_cast<int>(tiles.size()));
+    tiles.push_back(tile);
+    logUndo(UndoEntry::TilePlaced, city, slotIndex);
+    addToNetwork(tile.owner, city);
+    indexResources(city, slotIndex);
     return true;
 }
 
-const MerchantCity *GameBoard::getMerchantCity(const std::string &cityName) const
+GameBoard::MapLayout &GameBoard::editLayout()
 {
-    auto it = cities.find(cityName);
-    if (it != cities.end())
-    {
-        const auto &city = it->second;
-        return dynamic_cast<const MerchantCity *>(city.get());
-    }
-    return nullptr;
+    // A count of one means no other board holds the layout, and none can
+    // start sharing it without copying this board. Every layout is created
+    // non-const, so casting the constness away is fine.
+    if (layout.use_count() > 1)
+        layout = std::make_shared<MapLayout>(*layout);
+    return const_cast<MapLayout &>(*layout);
 }
 
-bool GameBoard::isConnectedToMerchantCity(const std::string &cityName) const
+int GameBoard::slotPosition(CityId city, int slotIndex) const
 {
-    std::vector<std::string> connectedCities = getConnectedCities(cityName);
-
-    for (const auto &connectedCity : connectedCities)
-    {
-        if (getMerchantCity(connectedCity) != nullptr)
-        {
-            return true;
-        }
-    }
+    const City *cityPtr = getCity(city);
+    if (!cityPtr || slotIndex < 0 || slotIndex >= static_cast<int>(cityPtr->slots.size()))
+        return -1;
+    return cityPtr->firstSlot + slotIndex;
+}
 
-    return false;
+int GameBoard::placedTileIndex(CityId city, int slotIndex) const
+{
+    int position = slotPosition(city, slotIndex);
+    return position >= 0 ? slotTiles[position].index : -1;
 }
-void printVector(const std::vector<std::string> &vec)
+
+const Tile *GameBoard::getPlacedTile(CityId city, int slotIndex) const
 {
-    std::cout << "City";
-    for (const auto &p : vec)
-    {
-        std::cout << " " << p;
-    }
-    std::cout << std::endl;
+    int index = placedTileIndex(city, slotIndex);
+    return index >= 0 ? &tiles[index] : nullptr;
 }
 
-std::vector<const MerchantCity *> GameBoard::getConnectedMerchantCities(const std::string &cityName) const
+bool GameBoard::flipTile(CityId city, int slotIndex)
 {
-    std::vector<const MerchantCity *> connectedMerchantCities;
-    std::vector<std::string> connectedCities = getConnectedCities(cityName);
-    for (const auto &connectedCity : connectedCities)
-    {
-        const MerchantCity *merchantCity = getMerchantCity(connectedCity);
-        if (merchantCity != nullptr)
-        {
-            connectedMerchantCities.push_back(merchantCity);
-        }
-    }
-    return connectedMerchantCities;
+    int index = placedTileIndex(city, slotIndex);
+    if (index < 0 || tiles[index].flipped)
+        return false;
+    tiles[index].flipped = true;
+    logUndo(UndoEntry::TileFlipped, city, slotIndex);
+    return true;
 }
 
-std::set<MerchantType> GameBoard::getConnectedMerchantTypes(const std::string &cityName) const
+void GameBoard::logUndo(UndoEntry::Kind kind, int a, int b, int c, int d)
 {
-    std::set<MerchantType> merchantTypes;
-    std::vector<const MerchantCity *> connectedMerchantCities = getConnectedMerchantCities(cityName);
+    if (recording)
+        undoLog.push_back({kind, a, b, c, d});
+}
 
-    for (const auto *merchantCity : connectedMerchantCities)
-    {
-        for (const auto &slot : merchantCity->slots)
-        {
-            if (slot.placedTile && slot.placedTile->type == TileType::Merchant)
-            {
-                const MerchantTile *merchantTile = dynamic_cast<const MerchantTile *>(slot.placedTile.get());
-                if (merchantTile)
-                {
-                    merchantTypes.insert(merchantTile->merchantType);
-                }
-            }
-        }
-    }
+void GameBoard::setRecording(bool on)
+{
+    recording = on;
+    undoLog.clear();
+}
 
-    return merchantTypes;
+void GameBoard::discardUndoLog()
+{
+    undoLog.clear();
+    undoEpoch++;
 }
 
-std::vector<std::string> GameBoard::getPlayerPlacedTiles(const Player &player) const
+void GameBoard::undoTo(size_t mark, std::vector<std::pair<CityId, int>> &slots, std::vector<std::pair<CityId, CityId>> &links)
 {
-    std::vector<std::string> playerTiles;
-    for (const auto &[cityName, city] : cities)
+    assert(mark <= undoLog.size() && "undo mark from a discarded log");
+    // Entries are reverted newest first, so each one sees the board exactly
+    // as it was right after the change it undoes
+    while (undoLog.size() > mark)
     {
-        for (const auto &slot : city->slots)
+        UndoEntry entry = undoLog.back();
+        undoLog.pop_back();
+        switch (entry.kind)
+        {
+        case UndoEntry::TilePlaced:
+            slotTiles[slotPosition(entry.a, entry.b)] = nullptr;
+            tiles.pop_back();
+            slots.emplace_back(entry.a, entry.b);
+            break;
+        case UndoEntry::ResourceIndexed:
+        {
+            const ResourceSlot &source = resourceSlots[entry.a].back();
+            resourceTotals[entry.a] -= getPlacedTile(source.city, source.slotIndex)->resource_amount;
+            resourceSlots[entry.a].pop_back();
+            break;
+        }
+        case UndoEntry::ResourceTaken:
+        {
+            Tile &tile = tiles[placedTileIndex(entry.a, entry.b)];
+            int kind = resourceKind(tile.type);
+            tile.resource_amount += entry.c;
+            resourceTotals[kind] += entry.c;
+            if (entry.d >= 0)
+                resourceSlots[kind].insert(resourceSlots[kind].begin() + entry.d, ResourceSlot{entry.a, entry.b});
+            slots.emplace_back(entry.a, entry.b);
+            break;
+        }
+        case UndoEntry::TileFlipped:
+            tiles[placedTileIndex(entry.a, entry.b)].flipped = false;
+            slots.emplace_back(entry.a, entry.b);
+            break;
+        case UndoEntry::LinkPlaced:
+            connections[entry.a].linkOwner = -1;
+            links.emplace_back(connections[entry.a].city1, connections[entry.a].city2);
+            break;
+        case UndoEntry::ComponentsMerged:
         {
-            if (slot.placedTile && slot.placedTile->owner == player.id)
+            // The dropped component's lists were spliced onto the kept one's
+            // and nothing later is still there; its own fields are intact
+            ComponentNode &kept = components[entry.a];
+            const ComponentNode &dropped = components[entry.b];
+            components[entry.c].nextCity = -1;
+            kept.lastCity = entry.c;
+            kept.cityCount -= dropped.cityCount;
+            for (CityId city = entry.b; city >= 0; city = components[city].nextCity)
+                components[city].component = entry.b;
+            if (dropped.firstMerchant >= 0)
             {
-                playerTiles.push_back(cityName);
+                if (entry.d >= 0)
+                    components[entry.d].nextMerchant = -1;
+                else
+                    kept.firstMerchant = -1;
+                kept.lastMerchant = entry.d;
             }
+            break;
+        }
+        case UndoEntry::NetworkGrew:
+        {
+            int row = networkRow(entry.a);
+            networkCities[row * getCityCount() + entry.b] = false;
+            networkOwners[row].cityCount--;
+            break;
+        }
         }
     }
-    return playerTiles;
 }
 
-std::vector<Connection> GameBoard::getPlayerPlacedLinks(const Player &player) const
+const City *GameBoard::getMerchantCity(CityId city) const
 {
-    std::vector<Connection> playerLinks;
-    for (const auto &connection : connections)
-    {
-        if (connection.linkOwner.get() == &player)
-        {
-            playerLinks.push_back(connection);
-        }
-    }
-    return playerLinks;
+    const City *cityPtr = getCity(city);
+    return cityPtr && cityPtr->merchant ? cityPtr : nullptr;
 }
 
-bool GameBoard::isCityInPlayerNetwork(const Player &player, const std::string &cityName) const
+bool GameBoard::isConnectedToMerchantCity(CityId city) const
 {
-    auto links = getPlayerPlacedLinks(player);
-    auto tiles = getPlayerPlacedTiles(player);
+    int component = getComponent(city);
+    return component >= 0 && components[component].firstMerchant >= 0;
+}
 
-    std::set<std::string> networkCities;
+std::vector<CityId> GameBoard::getConnectedMerchantCities(CityId city) const
+{
+    std::vector<CityId> merchantCities;
+    int component = getComponent(city);
+    if (component < 0)
+        return merchantCities;
+    for (CityId merchant = components[component].firstMerchant; merchant >= 0; merchant = components[merchant].nextMerchant)
+        merchantCities.push_back(merchant);
+    return merchantCities;
+}
 
-    // Add cities from links
-    for (const auto &link : links)
+std::set<MerchantType> GameBoard::getConnectedMerchantTypes(CityId city) const
+{
+    std::set<MerchantType> merchantTypes;
+    int component = getComponent(city);
+    CityId first = component >= 0 ? components[component].firstMerchant : -1;
+    for (CityId merchantCity = first; merchantCity >= 0; merchantCity = components[merchantCity].nextMerchant)
     {
-        networkCities.insert(link.city1);
-        networkCities.insert(link.city2);
+        for (size_t i = 0; i < layout->cities[merchantCity].slots.size(); i++)
+        {
+            const Tile *tile = getPlacedTile(merchantCity, static_cast<int>(i));
+            if (tile && tile->type == TileType::Merchant)
+            {
+                merchantTypes.insert(tile->merchantType);
+            }
+        }
     }
 
-    // Add cities from tiles
-    for (const auto &tile : tiles)
-    {
-        networkCities.insert(tile);
-    }
+    return merchantTypes;
+}
+
+bool GameBoard::isCityInPlayerNetwork(const Player &player, CityId city) const
+{
+    int row = networkRow(player.id);
     // No placed link or tiles free to place anywhere
-    if (networkCities.size() == 0)
+    if (row < 0 || networkOwners[row].cityCount == 0)
         return true;
-    // Check if the given cityName is in the network
-    return networkCities.find(cityName) != networkCities.end();
+    return city >= 0 && city < static_cast<CityId>(getCityCount()) && networkCities[row * getCityCount() + city];
 }
 
-const City *GameBoard::getCity(const std::string &cityName) const
+const City *GameBoard::getCity(CityId city) const
 {
-    auto it = cities.find(cityName);
-    if (it != cities.end())
-    {
-        return it->second.get();
-    }
-    return nullptr;
+    if (city < 0 || city >= static_cast<CityId>(layout->cities.size()) || !layout->cities[city].defined)
+        return nullptr;
+    return &layout->cities[city];
 }
 
-std::vector<std::pair<std::string, int>> GameBoard::findSellableTiles(const Player &player) const
+std::vector<std::pair<CityId, int>> GameBoard::findSellableTiles(const Player &player) const
 {
-    std::vector<std::pair<std::string, int>> sellableTiles;
+    // Merchant types and the beer a sale can draw on are the same for every
+    // city of a component, so they are gathered once per component
+    static const int MERCHANT_TYPES = static_cast<int>(MerchantType::Empty) + 1;
+    struct ComponentSummary
+    {
+        bool ready = false;
+        unsigned merchantTypes = 0;
+        int merchantBeer[MERCHANT_TYPES] = {};
+        int breweryBeer = 0;
+    };
+    std::vector<ComponentSummary> summaries(components.size());
+
+    auto summarize = [&](int component) -> const ComponentSummary &
+    {
+        ComponentSummary &summary = summaries[component];
+        if (summary.ready)
+            return summary;
+        summary.ready = true;
+        for (CityId merchantCity = components[component].firstMerchant; merchantCity >= 0;
+             merchantCity = components[merchantCity].nextMerchant)
+        {
+            for (size_t i = 0; i < layout->cities[merchantCity].slots.size(); i++)
+            {
+                const Tile *merchantTile = getPlacedTile(merchantCity, static_cast<int>(i));
+                if (!merchantTile || merchantTile->type != TileType::Merchant)
+                    continue;
+                summary.merchantTypes |= merchantTypeBit(merchantTile->merchantType);
+                summary.merchantBeer[static_cast<int>(merchantTile->merchantType)] += merchantTile->resource_amount;
+            }
+        }
+        for (const auto &source : getResourceSlots(TileType::Brewery))
+        {
+            if (components[source.city].component != component)
+                continue;
+            const Tile *brewery = getPlacedTile(source.city, source.slotIndex);
+            if (brewery->owner == player.id || isCityInPlayerNetwork(player, source.city))
+                summary.breweryBeer += brewery->resource_amount;
+        }
+        return summary;
+    };
 
-    for (const auto &[cityName, city] : cities)
+    std::vector<std::pair<CityId, int>> sellableTiles;
+    for (const auto &city : layout->cities)
     {
-        auto connectedMerchantTypes = getConnectedMerchantTypes(cityName);
-        if (connectedMerchantTypes.size() == 0)
-            continue;
-        for (size_t i = 0; i < city->slots.size(); i++)
+        for (size_t i = 0; i < city.slots.size(); i++)
         {
-            const auto &slot = city->slots[i];
-            if (!slot.placedTile || slot.placedTile->owner != player.id)
+            TileHandle handle = slotTiles[city.firstSlot + i];
+            if (!handle)
+                continue;
+            const Tile &tile = getTile(handle);
+            if (tile.owner != player.id)
                 continue;
 
-            TileType tileType = slot.placedTile->type;
+            TileType tileType = tile.type;
             if (!isSellableTileType(tileType))
                 continue;
 
-            if (canSellTile(connectedMerchantTypes, tileType) &&
-                hasEnoughBeer(cityName, player, slot.placedTile->beer_demand, getTileRequiredMerchantType(tileType)))
-            {
-                sellableTiles.emplace_back(cityName, i);
-            }
+            const ComponentSummary &summary = summarize(components[city.id].component);
+            MerchantType requiredType = getTileRequiredMerchantType(tileType);
+            if ((summary.merchantTypes & (merchantTypeBit(requiredType) | merchantTypeBit(MerchantType::Any))) == 0)
+                continue;
+
+            int beer = summary.breweryBeer +
+                       summary.merchantBeer[static_cast<int>(requiredType)] +
+                       summary.merchantBeer[static_cast<int>(MerchantType::Any)];
+            if (beer >= tile.beer_demand)
+                sellableTiles.emplace_back(city.id, i);
         }
     }
     return sellableTiles;
@@ -6,6 +6,9 @@
 #include <unordered_map>
 #include <set>
 #include <memory>
+#include <cstddef>
+#include <cstdint>
+#include "CityId.hpp"
 #include "Tile.hpp"
 #include "Player.hpp"
 
@@ -18,39 +21,53 @@ enum class MerchantBonus
     Points3,
 };
 
+/// Index of a placed tile in its board's tile arena. An empty slot holds
+/// the default handle, which converts from nullptr.
+struct TileHandle
+{
+    int index = -1;
+
+    TileHandle() = default;
+    TileHandle(std::nullptr_t) {}
+    explicit TileHandle(int i) : index(i) {}
+    explicit operator bool() const { return index >= 0; }
+};
+
+/// What may be built in a slot. What is built there is board state, see
+/// GameBoard::getPlacedTile.
 struct Slot
 {
     std::vector<TileType> allowedTileTypes;
-    std::shared_ptr<Tile> placedTile;
 };
 
 struct City
 {
+    CityId id;
     std::string name;
     std::vector<Slot> slots;
+    // Position of slots[0] in the board's slot table
+    int firstSlot = 0;
+    // False for a name only referenced by a connection
+    bool defined = false;
+    // Merchant cities are tagged rather than subclassed, so cities are
+    // plain values
+    bool merchant = false;
+    MerchantBonus merchant_bonus = MerchantBonus::Income2;
 
-    City(const std::string &cityName) : name(cityName) {}
-    virtual ~City() = default;
-};
-
-struct MerchantCity : public City
-{
-    MerchantBonus merchant_bonus;
-
-    MerchantCity(const std::string &cityName, MerchantBonus mb)
-        : City(cityName), merchant_bonus(mb) {}
-
-    ~MerchantCity() override = default;
+    City(CityId cityId, const std::string &cityName) : id(cityId), name(cityName) {}
 };
 
 struct Connection
 {
-    std::string city1;
-    std::string city2;
-    std::shared_ptr<Player> linkOwner;
+    CityId city1;
+    CityId city2;
+    // Id of the player whose link is placed here, -1 while there is none
+    int linkOwner;
+
+    Connection(CityId c1, CityId c2)
+        : city1(std::min(c1, c2)), city2(std::max(c1, c2)), linkOwner(-1) {}
 
-    Connection(const std::string &c1, const std::string &c2)
-        : city1(std::min(c1, c2)), city2(std::max(c1, c2)), linkOwner(nullptr) {}
+    bool hasLink() const { return linkOwner >= 0; }
 
     bool operator<(const Connection &other) const
     {
@@ -58,54 +75,204 @@ struct Connection
     }
 };
 
+/// A slot whose placed tile still holds coal, iron or beer
+struct ResourceSlot
+{
+    CityId city;
+    int slotIndex;
+};
+
+/// The map and everything placed on it. Copies are independent and cheap:
+/// the map layout is shared between copies and everything placed on it is
+/// a flat vector, so a copy costs a handful of allocations.
 class GameBoard
 {
 private:
-    std::unordered_map<std::string, std::unique_ptr<City>> cities;
-    std::set<Connection> connections;
-    std::vector<std::string> getPlayerPlacedTiles(const Player &player) const;
-    std::vector<Connection> getPlayerPlacedLinks(const Player &player) const;
-    int getAvailableBeerFromMerchantSlots(const std::string &cityName, const MerchantType &allowedType) const;
-    int getAvailableBeerFromBreweries(const std::string &cityName, const Player &player) const;
-    bool hasEnoughBeer(const std::string &cityName, const Player &player, int beerDemand, const MerchantType &allowedType) const;
+    // Everything fixed once the map is built. Shared by copies of the
+    // board; only the map-building functions change it, and they copy it
+    // first through editLayout.
+    struct MapLayout
+    {
+        // Indexed by CityId. A name that is only referenced by a connection
+        // has an id but an undefined City.
+        std::vector<City> cities;
+        std::vector<std::string> cityNames;
+        std::unordered_map<std::string, CityId> cityIds;
+        // CSR adjacency over connections: the neighbours of city c are
+        // adjacentCities[adjacencyOffsets[c] .. adjacencyOffsets[c + 1]), and
+        // adjacentConnections holds the matching index into connections
+        std::vector<int> adjacencyOffsets;
+        std::vector<CityId> adjacentCities;
+        std::vector<int> adjacentConnections;
+    };
+    std::shared_ptr<const MapLayout> layout = std::make_shared<MapLayout>();
+    MapLayout &editLayout();
+    // The tile in each slot, city by city in id order starting at
+    // City::firstSlot
+    std::vector<TileHandle> slotTiles;
+    // Every tile placed in this game, referenced from slots by TileHandle.
+    // Tiles are never removed, so handles stay valid.
+    std::vector<Tile> tiles;
+    // Sorted by (city1, city2), so indices change only while the map is built
+    std::vector<Connection> connections;
+    // Connected components of the placed-link network, labelled by one of
+    // their cities. Members and merchant cities of a component are linked
+    // lists threaded through these per-city nodes, so merging is a splice.
+    // placeLink merges components incrementally (smaller into larger);
+    // anything that changes the map or removes links rebuilds them in bulk.
+    struct ComponentNode
+    {
+        int component;
+        // Next city and next merchant city of the same component, -1 at the end
+        CityId nextCity;
+        CityId nextMerchant;
+        // Only meaningful on a component's label city, which heads its list
+        CityId lastCity;
+        CityId firstMerchant;
+        CityId lastMerchant;
+        int cityCount;
+    };
+    std::vector<ComponentNode> components;
+    // Cities holding a tile or touching a link of each player: one row of
+    // getCityCount() flags per entry of networkOwners. Tiles and links are
+    // only ever added, so placeTile and placeLink just set flags;
+    // clearLinks rebuilds.
+    struct NetworkOwner
+    {
+        int playerId;
+        int cityCount;
+    };
+    std::vector<NetworkOwner> networkOwners;
+    std::vector<bool> networkCities;
+    int networkRow(int playerId) const;
+    // Slots holding resources and the amount left on them, for coal, iron,
+    // brewery and merchant (beer) tiles
+    static const int RESOURCE_KINDS = 4;
+    std::vector<ResourceSlot> resourceSlots[RESOURCE_KINDS];
+    int resourceTotals[RESOURCE_KINDS] = {};
+    static int resourceKind(TileType type);
+    void rebuildResources();
+    void indexResources(CityId city, int slotIndex);
+    // Position of a slot in slotTiles, -1 when there is no such slot
+    int slotPosition(CityId city, int slotIndex) const;
+    // Arena index of the tile in a slot, -1 when there is none
+    int placedTileIndex(CityId city, int slotIndex) const;
+    CityId internCity(const std::string &name);
+    void defineCity(CityId id, bool merchant, MerchantBonus mb);
+    void rebuildAdjacency();
+    void rebuildComponents();
+    void mergeComponents(CityId city1, CityId city2);
+    void rebuildNetworks();
+    void addToNetwork(int playerId, CityId city);
+    int findConnection(CityId city1, CityId city2) const;
+
+    // A change logged while recording; what a..d hold depends on the kind
+    struct UndoEntry
+    {
+        enum Kind
+        {
+            TilePlaced,       // a: city, b: slot
+            ResourceIndexed,  // a: resource kind
+            ResourceTaken,    // a: city, b: slot, c: amount, d: position in the index if it left, else -1
+            TileFlipped,      // a: city, b: slot
+            LinkPlaced,       // a: connection index
+            ComponentsMerged, // a: kept component, b: dropped one, c/d: kept last city/merchant before
+            NetworkGrew,      // a: player id, b: city
+        } kind;
+        int a;
+        int b;
+        int c;
+        int d;
+    };
+    bool recording = false;
+    std::vector<UndoEntry> undoLog;
+    uint64_t undoEpoch = 0;
+    void logUndo(UndoEntry::Kind kind, int a, int b = 0, int c = 0, int d = 0);
+    // A rebuild or a new connection invalidates logged entries
+    void discardUndoLog();
 
 public:
     // Initialization
     void initializeBrassBirminghamMap();
 
-    // Create the board
-    City *addCity(const std::string &name);
+    // Create the board. Names are interned to ids here; ids never change
+    // once assigned. Slots are always added empty, tiles only enter the
+    // board through placeTile.
+    CityId addCity(const std::string &name);
     void addSlot(const std::string &cityName, const Slot &slot);
-    MerchantCity *addMerchantCity(const std::string &name, MerchantBonus mb);
+    void addSlot(CityId city, const Slot &slot);
+    CityId addMerchantCity(const std::string &name, MerchantBonus mb);
+    // The reference is valid until the next addConnection
     Connection &addConnection(const std::string &city1, const std::string &city2);
 
-    // City and Connection Queries
-    const City *getCity(const std::string &cityName) const;
-    const std::unordered_map<std::string, std::unique_ptr<City>> &getCities() const { return cities; }
-    std::vector<std::string> getConnections(const std::string &cityName) const;
-    std::vector<std::string> getConnectedCities(const std::string &startCity) const;
-    bool isConnectedToMerchantCity(const std::string &cityName) const;
-    std::vector<const MerchantCity *> getConnectedMerchantCities(const std::string &cityName) const;
-    std::set<MerchantType> getConnectedMerchantTypes(const std::string &cityName) const;
+    // Name translation, for the JSON boundary
+    CityId getCityId(const std::string &cityName) const;
+    const std::string &getCityName(CityId city) const;
+    size_t getCityCount() const { return layout->cityNames.size(); }
+
+    // City and Connection Queries. Cities are valid until the next map edit;
+    // nullptr for an unknown or undefined city.
+    const City *getCity(CityId city) const;
+    std::vector<CityId> getConnections(CityId city) const;
+    // Cities reachable over placed links in BFS (distance) order, starting
+    // with startCity itself
+    std::vector<CityId> getConnectedCities(CityId startCity) const;
+    bool areConnected(CityId city1, CityId city2) const;
+    // Component label of a city, shared by every city reachable from it
+    int getComponent(CityId city) const;
+    std::vector<CityId> getComponentCities(int component) const;
+    bool isConnectedToMerchantCity(CityId city) const;
+    // Merchant cities in the same component, in no particular order
+    std::vector<CityId> getConnectedMerchantCities(CityId city) const;
+    std::set<MerchantType> getConnectedMerchantTypes(CityId city) const;
 
     // Link Management
-    bool placeLink(const std::string &city1, const std::string &city2, std::shared_ptr<Player> player);
+    bool placeLink(CityId city1, CityId city2, int playerId);
     std::vector<Connection> getPlacedLinks() const;
+    // Every connection of the map, with or without a link, sorted by
+    // (city1, city2)
+    const std::vector<Connection> &getAllConnections() const { return connections; }
+    // Remove every placed link, e.g. at the end of the canal era
+    void clearLinks();
 
     // Tile Management
-    bool canPlaceTile(const std::string &cityName, int slotIndex, const Tile &tile) const;
-    bool placeTile(const std::string &cityName, int slotIndex, const Tile &tile);
-    std::vector<std::pair<std::string, int>> findSellableTiles(const Player &player) const;
+    bool canPlaceTile(CityId city, int slotIndex, const Tile &tile) const;
+    bool placeTile(CityId city, int slotIndex, const Tile &tile);
+    const Tile &getTile(TileHandle handle) const { return tiles[handle.index]; }
+    // nullptr when the slot is empty or does not exist
+    const Tile *getPlacedTile(CityId city, int slotIndex) const;
+    // Returns true if the tile was not flipped before
+    bool flipTile(CityId city, int slotIndex);
+    std::vector<std::pair<CityId, int>> findSellableTiles(const Player &player) const;
 
     // Resource Queries
-    int getTotalResourceCoal(const std::string &startCity) const;
+    int getTotalResourceCoal(CityId startCity) const;
     int getTotalResourceIron() const;
+    // Slots of coal, iron, brewery or merchant tiles with resources left, in
+    // placement order
+    const std::vector<ResourceSlot> &getResourceSlots(TileType type) const;
+    int getResourceTotal(TileType type) const;
+    // Take up to amount resources from a placed tile. Returns how many were
+    // taken; an emptied tile leaves the index.
+    int consumeResource(CityId city, int slotIndex, int amount);
 
     // Player Network
-    bool isCityInPlayerNetwork(const Player &player, const std::string &cityName) const;
+    bool isCityInPlayerNetwork(const Player &player, CityId city) const;
+
+    // Undo log. While recording, tile and link placements, flips and
+    // resource consumption are logged so undoTo can revert them, newest
+    // first. Map edits and clearLinks discard the log and bump the epoch,
+    // so whoever holds marks can tell they are stale.
+    void setRecording(bool on);
+    void clearUndoLog() { undoLog.clear(); }
+    size_t getUndoMark() const { return undoLog.size(); }
+    uint64_t getUndoEpoch() const { return undoEpoch; }
+    // Revert everything logged after mark. The slots and links it changed
+    // are appended to slots and links.
+    void undoTo(size_t mark, std::vector<std::pair<CityId, int>> &slots, std::vector<std::pair<CityId, CityId>> &links);
 
-    // Merchant City
-    const MerchantCity *getMerchantCity(const std::string &cityName) const;
+    // Merchant City, nullptr if the city is not one
+    const City *getMerchantCity(CityId city) const;
 };
 
-#endif // GAMEBOARD_HPP
\ No newline at end of file
+#endif // GAMEBOARD_HPP
@@ -0,0 +1,8 @@
+#include "GameRoom.hpp"
+
+GameRoom::GameRoom(const std::string& id, websocketpp::lib::asio::io_service& io_service)
+    : m_id(id), m_strand(io_service) {}
+
+void GameRoom::post(std::function<void()> task) {
+    m_strand.post(std::move(task));
+}
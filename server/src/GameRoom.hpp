@@ -0,0 +1,53 @@
+#pragma once
+
+#include <websocketpp/common/asio.hpp>
+#include <websocketpp/common/connection_hdl.hpp>
+#include "Backpressure.hpp"
+#include "GameState.hpp"
+#include "WireProtocol.hpp"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+/// One independent game table. Every mutation of the room's GameState and
+/// connection list is posted to the room's strand, so work for one room is
+/// serialized while different rooms run in parallel on the io thread pool.
+class GameRoom {
+public:
+    struct Member {
+        std::shared_ptr<Player> player;
+        WireFormat format;
+        // Negotiated permessage-deflate
+        bool deflate;
+        OutboundState outbound;
+    };
+    typedef std::map<websocketpp::connection_hdl, Member, std::owner_less<websocketpp::connection_hdl>> con_list;
+
+    GameRoom(const std::string& id, websocketpp::lib::asio::io_service& io_service);
+
+    const std::string& id() const { return m_id; }
+
+    // Queue a task with exclusive access to this room's state
+    void post(std::function<void()> task);
+
+    // City ids are fixed once the board is built, so translating names is
+    // safe from any thread
+    CityId cityId(const std::string& name) const { return m_game_state.m_board.getCityId(name); }
+
+    // Only valid from inside a posted task
+    GameState& state() { return m_game_state; }
+    con_list& connections() { return m_connections; }
+
+private:
+    friend class RoomManager;
+
+    std::string m_id;
+    websocketpp::lib::asio::io_service::strand m_strand;
+    GameState m_game_state;
+    con_list m_connections;
+
+    // Number of sessions holding this room, maintained by RoomManager
+    std::atomic<size_t> m_members{0};
+};
@@ -5,10 +5,28 @@
 #include "IncomeFunctions.hpp"
 #include <nlohmann/json.hpp>
 #include <algorithm>
+#include <optional>
 #include <random>
 #include <iostream>
 #include <algorithm>
 
+bool StateChanges::empty() const
+{
+    return slots.empty() && links.empty() && removedLinks.empty() && players.empty() && removedPlayers.empty() &&
+           !markets && !era;
+}
+
+void StateChanges::clear()
+{
+    slots.clear();
+    links.clear();
+    removedLinks.clear();
+    players.clear();
+    removedPlayers.clear();
+    markets = false;
+    era = false;
+}
+
 GameState::GameState()
 {
     m_board.initializeBrassBirminghamMap();
@@ -16,18 +34,52 @@ GameState::GameState()
     iron_market.buy(2);
 }
 
+GameState::GameState(const GameState &other)
+{
+    *this = other;
+}
+
+GameState &GameState::operator=(const GameState &other)
+{
+    if (this == &other)
+        return *this;
+    // Players are handed out as shared_ptr, so each copy needs its own
+    m_players.clear();
+    for (const auto &[id, player] : other.m_players)
+        m_players.emplace_hint(m_players.end(), id, std::make_shared<Player>(*player));
+    m_next_id = other.m_next_id;
+    coal_market = other.coal_market;
+    iron_market = other.iron_market;
+    era = other.era;
+    m_seq = other.m_seq;
+    m_changes = other.m_changes;
+    m_board = other.m_board;
+    m_undoEnabled = other.m_undoEnabled;
+    m_undoEpoch = other.m_undoEpoch;
+    m_undo = other.m_undo;
+    m_undoPlayers = other.m_undoPlayers;
+    return *this;
+}
+
 std::shared_ptr<Player> GameState::addPlayer()
 {
     auto new_player = std::make_shared<Player>(m_next_id++);
     new_player->income_level = 10;
     new_player->money = 30;
     m_players[new_player->id] = new_player;
+    m_changes.players.insert(new_player->id);
+    clearUndo();
     return new_player;
 }
 
 void GameState::removePlayer(int id)
 {
-    m_players.erase(id);
+    if (m_players.erase(id) > 0)
+    {
+        m_changes.players.erase(id);
+        m_changes.removedPlayers.insert(id);
+        clearUndo();
+    }
 }
 
 bool GameState::handleAction(int playerId, const GameAction &action)
@@ -37,35 +89,55 @@ bool GameState::handleAction(int playerId, const GameAction &action)
     {
         return false; // Player not found
     }
-    auto &player = playerIt->second;
+    Player &player = *playerIt->second;
+    if (!m_undoEnabled)
+        return applyAction(player, action);
+
+    checkUndoEpoch();
+    m_undo.push_back({m_board.getUndoMark(), m_undoPlayers.size(), coal_market, iron_market});
+    saveForUndo(player);
+    if (applyAction(player, action))
+        return true;
+    // Rejected actions change nothing, so there is nothing to keep
+    m_undoPlayers.erase(m_undoPlayers.begin() + m_undo.back().playersMark, m_undoPlayers.end());
+    m_undo.pop_back();
+    return false;
+}
+
+bool GameState::applyAction(Player &player, const GameAction &action)
+{
     switch (action.type)
     {
     case GameAction::Type::PlaceTile:
     {
-        return handleTilePlacement(*player, action);
+        return handleTilePlacement(player, action);
         break;
     }
     case GameAction::Type::PlaceLink:
     {
-        if (m_board.isCityInPlayerNetwork(*player.get(), action.cityName) || m_board.isCityInPlayerNetwork(*player.get(), action.cityName2))
+        if ((m_board.isCityInPlayerNetwork(player, action.city) || m_board.isCityInPlayerNetwork(player, action.city2)) &&
+            m_board.placeLink(action.city, action.city2, player.id))
         {
-            return m_board.placeLink(action.cityName, action.cityName2, player);
+            m_changes.links.insert(std::minmax(action.city, action.city2));
+            return true;
         }
         return false;
     }
     case GameAction::Type::Develop:
     {
-        return handleDevelop(*player.get(), action);
+        return handleDevelop(player, action);
     }
     case GameAction::Type::Sell:
     {
-        return handleSell(*player.get(), action);
+        return handleSell(player, action);
     }
     case GameAction::Type::TakeLoan:
     {
-        if (player->income_level > 2)
+        int newLevel = loanLevel(player.income_level);
+        if (newLevel >= 0)
         {
-            player->income_level = takeLoan(player->income_level);
+            player.income_level = newLevel;
+            m_changes.players.insert(player.id);
             return true;
         }
         return false;
@@ -76,20 +148,95 @@ bool GameState::handleAction(int playerId, const GameAction &action)
     }
 }
 
-int GameState::getTilePrice(const std::string &cityName, const Tile tile)
+void GameState::setUndoEnabled(bool enabled)
+{
+    m_undoEnabled = enabled;
+    m_board.setRecording(enabled);
+    clearUndo();
+}
+
+void GameState::saveForUndo(const Player &player)
+{
+    if (!m_undoEnabled || m_undo.empty())
+        return;
+    for (size_t i = m_undo.back().playersMark; i < m_undoPlayers.size(); i++)
+    {
+        if (m_undoPlayers[i].id == player.id)
+            return;
+    }
+    m_undoPlayers.push_back(player);
+}
+
+void GameState::clearUndo()
+{
+    m_undo.clear();
+    m_undoPlayers.clear();
+    m_board.clearUndoLog();
+    m_undoEpoch = m_board.getUndoEpoch();
+}
+
+void GameState::checkUndoEpoch()
+{
+    if (m_undoEpoch != m_board.getUndoEpoch())
+        clearUndo();
+}
+
+size_t GameState::undo(size_t count)
+{
+    std::vector<std::pair<CityId, int>> slots;
+    std::vector<std::pair<CityId, CityId>> links;
+    checkUndoEpoch();
+    size_t undone = 0;
+    for (; undone < count && !m_undo.empty(); undone++)
+    {
+        const ActionUndo &entry = m_undo.back();
+        m_board.undoTo(entry.boardMark, slots, links);
+        for (size_t i = entry.playersMark; i < m_undoPlayers.size(); i++)
+        {
+            auto playerIt = m_players.find(m_undoPlayers[i].id);
+            if (playerIt == m_players.end())
+                continue;
+            *playerIt->second = m_undoPlayers[i];
+            m_changes.players.insert(playerIt->first);
+        }
+        if (coal_market.getCubeCount() != entry.coal.getCubeCount() ||
+            iron_market.getCubeCount() != entry.iron.getCubeCount())
+            m_changes.markets = true;
+        coal_market = entry.coal;
+        iron_market = entry.iron;
+        m_undoPlayers.erase(m_undoPlayers.begin() + entry.playersMark, m_undoPlayers.end());
+        m_undo.pop_back();
+    }
+
+    for (const auto &slot : slots)
+        m_changes.slots.insert(slot);
+    for (const auto &link : links)
+    {
+        m_changes.links.erase(link);
+        m_changes.removedLinks.insert(link);
+    }
+    return undone;
+}
+
+int GameState::getTilePrice(CityId city, const Tile &tile) const
+{
+    return tilePrice(tile, m_board.getTotalResourceCoal(city), m_board.isConnectedToMerchantCity(city));
+}
+
+int GameState::tilePrice(const Tile &tile, int coalInReach, bool merchantInReach) const
 {
     const int CANT_BUY = 2147483647; // max int
     int total_cost = tile.cost_money;
     int cost_coal = tile.cost_coal;
     if (cost_coal > 0)
     {
-        cost_coal = cost_coal - m_board.getTotalResourceCoal(cityName);
+        cost_coal = cost_coal - coalInReach;
     }
-    if (cost_coal > 0 && m_board.isConnectedToMerchantCity(cityName))
+    if (cost_coal > 0 && merchantInReach)
     {
         total_cost += coal_market.getPrice(cost_coal);
     }
-    if (cost_coal > 0 && not m_board.isConnectedToMerchantCity(cityName))
+    if (cost_coal > 0 && not merchantInReach)
     {
         return CANT_BUY;
     }
@@ -105,175 +252,242 @@ int GameState::getTilePrice(const std::string &cityName, const Tile tile)
     return total_cost;
 }
 
-std::vector<ResourceOption> GameState::findAvailableResources(const std::string &startCity, TileType resourceType, Player &player, int amountNeeded) const
+void GameState::forEachLegalAction(int playerId, const std::function<void(const GameAction &)> &visit) const
 {
-    std::vector<ResourceOption> options;
+    auto playerIt = m_players.find(playerId);
+    if (playerIt == m_players.end())
+        return;
+    const Player &player = *playerIt->second;
 
-    if (resourceType == TileType::Coal)
+    static const TileType INDUSTRIES[] = {TileType::Coal, TileType::Iron, TileType::Cotton,
+                                          TileType::Manufacturer, TileType::Pottery, TileType::Brewery};
+    static const int INDUSTRY_COUNT = sizeof(INDUSTRIES) / sizeof(INDUSTRIES[0]);
+
+    // The top tile of each pile, wherever it goes
+    std::optional<Tile> nextTiles[INDUSTRY_COUNT];
+    for (int i = 0; i < INDUSTRY_COUNT; i++)
     {
-        // For coal, only consider connected cities
-        std::vector<std::string> connectedCities = m_board.getConnectedCities(startCity);
+        if (TileDescriptor next = player.player_board.peekTile(INDUSTRIES[i]))
+            nextTiles[i] = next.makeTile();
+    }
 
-        for (const auto &cityName : connectedCities)
+    // Coal on the board is shared by every city of a component
+    std::vector<int> componentCoal(m_board.getCityCount(), 0);
+    for (const auto &source : m_board.getResourceSlots(TileType::Coal))
+        componentCoal[m_board.getComponent(source.city)] += m_board.getPlacedTile(source.city, source.slotIndex)->resource_amount;
+
+    GameAction action;
+    action.type = GameAction::Type::PlaceTile;
+    for (CityId cityId = 0; cityId < static_cast<CityId>(m_board.getCityCount()); cityId++)
+    {
+        const City *cityPtr = m_board.getCity(cityId);
+        if (!cityPtr)
+            continue;
+        int coalInReach = componentCoal[m_board.getComponent(cityId)];
+        bool merchantInReach = m_board.isConnectedToMerchantCity(cityId);
+        for (size_t slotIndex = 0; slotIndex < cityPtr->slots.size(); slotIndex++)
         {
-            const auto *city = m_board.getCity(cityName);
-            if (!city)
+            const Slot &slot = cityPtr->slots[slotIndex];
+            if (m_board.getPlacedTile(cityId, static_cast<int>(slotIndex)))
                 continue;
-
-            for (size_t i = 0; i < city->slots.size(); ++i)
+            for (int i = 0; i < INDUSTRY_COUNT; i++)
             {
-                const auto &slot = city->slots[i];
-                if (slot.placedTile && slot.placedTile->type == TileType::Coal)
-                {
-                    int available = slot.placedTile->resource_amount;
-                    if (available > 0)
-                    {
-                        options.push_back({cityName, static_cast<int>(i), std::min(available, amountNeeded)});
-                    }
-                }
+                if (!nextTiles[i] ||
+                    std::find(slot.allowedTileTypes.begin(), slot.allowedTileTypes.end(), INDUSTRIES[i]) == slot.allowedTileTypes.end() ||
+                    player.money < tilePrice(*nextTiles[i], coalInReach, merchantInReach))
+                    continue;
+                action.city = cityPtr->id;
+                action.slotIndex = static_cast<int>(slotIndex);
+                action.tileType = INDUSTRIES[i];
+                visit(action);
             }
         }
     }
-    else if (resourceType == TileType::Iron)
+
+    action = GameAction();
+    action.type = GameAction::Type::PlaceLink;
+    for (const auto &connection : m_board.getAllConnections())
     {
-        // For iron, consider all cities on the board
-        const auto &allCities = m_board.getCities();
+        if (connection.hasLink() ||
+            (!m_board.isCityInPlayerNetwork(player, connection.city1) && !m_board.isCityInPlayerNetwork(player, connection.city2)))
+            continue;
+        action.city = connection.city1;
+        action.city2 = connection.city2;
+        visit(action);
+    }
 
-        for (const auto &[cityName, city] : allCities)
+    action = GameAction();
+    action.type = GameAction::Type::Sell;
+    for (const auto &[city, slotIndex] : m_board.findSellableTiles(player))
+    {
+        action.city = city;
+        action.slotIndex = slotIndex;
+        visit(action);
+    }
+
+    // Developing two tiles of the same industry needs two in its pile;
+    // the order of a pair does not matter, so only one is listed
+    action = GameAction();
+    action.type = GameAction::Type::Develop;
+    bool canDevelopOne = player.money >= iron_market.getPrice(1);
+    bool canDevelopTwo = player.money >= iron_market.getPrice(2);
+    for (int i = 0; i < INDUSTRY_COUNT && canDevelopOne; i++)
+    {
+        size_t remaining = player.player_board.getRemainingTileAmount(INDUSTRIES[i]);
+        if (remaining == 0)
+            continue;
+        action.tileType = INDUSTRIES[i];
+        action.tileType2 = TileType::NullTile;
+        visit(action);
+        for (int j = i; j < INDUSTRY_COUNT && canDevelopTwo; j++)
         {
-            for (size_t i = 0; i < city->slots.size(); ++i)
-            {
-                const auto &slot = city->slots[i];
-                if (slot.placedTile && slot.placedTile->type == TileType::Iron)
-                {
-                    int available = slot.placedTile->resource_amount;
-                    if (available > 0)
-                    {
-                        options.push_back({cityName, static_cast<int>(i), std::min(available, amountNeeded)});
-                    }
-                }
-            }
+            if (player.player_board.getRemainingTileAmount(INDUSTRIES[j]) < (j == i ? 2u : 1u))
+                continue;
+            action.tileType2 = INDUSTRIES[j];
+            visit(action);
         }
     }
-    else if (resourceType == TileType::Brewery)
+
+    if (loanLevel(player.income_level) >= 0)
     {
-        // Check connected cities for Brewery tiles
-        std::vector<std::string> connectedCities = m_board.getConnectedCities(startCity);
-        connectedCities.push_back(startCity); // Include the start city itself
+        action = GameAction();
+        action.type = GameAction::Type::TakeLoan;
+        visit(action);
+    }
+}
+
+std::vector<GameAction> GameState::getLegalActions(int playerId) const
+{
+    std::vector<GameAction> actions;
+    forEachLegalAction(playerId, [&](const GameAction &action)
+                       { actions.push_back(action); });
+    return actions;
+}
+
+nlohmann::json GameState::getLegalMoves(int playerId) const
+{
+    nlohmann::json moves;
+    moves["type"] = "legalMoves";
+    moves["seq"] = m_seq;
+    moves["actions"] = nlohmann::json::array();
+    forEachLegalAction(playerId, [&](const GameAction &action)
+                       { moves["actions"].push_back(actionToJson(action)); });
+    return moves;
+}
 
-        for (const auto &cityName : connectedCities)
+std::vector<ResourceOption> GameState::findAvailableResources(CityId startCity, TileType resourceType, Player &player, int amountNeeded) const
+{
+    std::vector<ResourceOption> options;
+    auto amountAt = [&](const ResourceSlot &source)
+    {
+        return std::min(m_board.getPlacedTile(source.city, source.slotIndex)->resource_amount, amountNeeded);
+    };
+
+    // The index lists sources in placement order. Rules order them by city,
+    // then by slot within a city: closest city first for connected sources,
+    // board order for the rest.
+    std::vector<int> distanceRank;
+    auto sortFrom = [&](size_t first, bool byDistance)
+    {
+        if (options.size() - first < 2)
+            return;
+        if (byDistance && distanceRank.empty())
         {
-            const auto *city = m_board.getCity(cityName);
-            if (!city)
-                continue;
+            std::vector<CityId> connected = m_board.getConnectedCities(startCity);
+            distanceRank.assign(m_board.getCityCount(), 0);
+            for (size_t i = 0; i < connected.size(); i++)
+                distanceRank[connected[i]] = static_cast<int>(i);
+        }
+        auto cityRank = [&](CityId city)
+        { return byDistance ? distanceRank[city] : city; };
+        std::sort(options.begin() + first, options.end(), [&](const ResourceOption &a, const ResourceOption &b)
+                  {
+            int rankA = cityRank(a.city);
+            int rankB = cityRank(b.city);
+            return rankA != rankB ? rankA < rankB : a.slotIndex < b.slotIndex; });
+    };
 
-            for (size_t i = 0; i < city->slots.size(); ++i)
-            {
-                const auto &slot = city->slots[i];
-                if (slot.placedTile && slot.placedTile->type == TileType::Brewery)
-                {
-                    int available = slot.placedTile->resource_amount;
-                    if (available > 0)
-                    {
-                        options.push_back({cityName, static_cast<int>(i), std::min(available, amountNeeded)});
-                    }
-                }
-            }
+    if (resourceType == TileType::Coal)
+    {
+        // For coal, only consider connected cities, the closest has to be used first
+        for (const auto &source : m_board.getResourceSlots(TileType::Coal))
+        {
+            if (m_board.areConnected(startCity, source.city))
+                options.push_back({source.city, source.slotIndex, amountAt(source)});
         }
+        sortFrom(0, true);
+    }
+    else if (resourceType == TileType::Iron)
+    {
+        // For iron, consider all cities on the board
+        for (const auto &source : m_board.getResourceSlots(TileType::Iron))
+            options.push_back({source.city, source.slotIndex, amountAt(source)});
+        sortFrom(0, false);
+    }
+    else if (resourceType == TileType::Brewery)
+    {
+        // Check connected cities for Brewery tiles
+        const auto &breweries = m_board.getResourceSlots(TileType::Brewery);
+        for (const auto &source : breweries)
+        {
+            if (m_board.areConnected(startCity, source.city))
+                options.push_back({source.city, source.slotIndex, amountAt(source)});
+        }
+        sortFrom(0, true);
 
         // Check merchant cities for available beer
-        auto connectedMerchantCities = m_board.getConnectedMerchantCities(startCity);
-        for (const auto *merchantCity : connectedMerchantCities)
+        size_t merchants = options.size();
+        for (const auto &source : m_board.getResourceSlots(TileType::Merchant))
         {
-            for (size_t i = 0; i < merchantCity->slots.size(); ++i)
-            {
-                const auto &slot = merchantCity->slots[i];
-                if (slot.placedTile && slot.placedTile->type == TileType::Merchant)
-                {
-                    if (slot.placedTile->resource_amount > 0)
-                    {
-                        options.push_back({merchantCity->name, -1, std::min(slot.placedTile->resource_amount, amountNeeded)});
-                    }
-                }
-            }
+            if (m_board.areConnected(startCity, source.city))
+                options.push_back({source.city, source.slotIndex, amountAt(source)});
         }
+        sortFrom(merchants, true);
 
         // Check player's own unconnected Brewery tiles
-        for (const auto &[cityName, city] : m_board.getCities())
+        size_t unconnected = options.size();
+        for (const auto &source : breweries)
         {
-            if (std::find(connectedCities.begin(), connectedCities.end(), cityName) != connectedCities.end())
-            {
-                continue; // Skip already checked connected cities
-            }
-
-            for (size_t i = 0; i < city->slots.size(); ++i)
-            {
-                const auto &slot = city->slots[i];
-                if (slot.placedTile && slot.placedTile->type == TileType::Brewery && slot.placedTile->owner == player.id)
-                {
-                    int available = slot.placedTile->resource_amount;
-                    if (available > 0)
-                    {
-                        options.push_back({cityName, static_cast<int>(i), std::min(available, amountNeeded)});
-                    }
-                }
-            }
+            const Tile *tile = m_board.getPlacedTile(source.city, source.slotIndex);
+            if (tile->owner == player.id && !m_board.areConnected(startCity, source.city))
+                options.push_back({source.city, source.slotIndex, amountAt(source)});
         }
+        sortFrom(unconnected, false);
     }
 
     return options;
 }
-int GameState::consumeResources(Tile &tile, int amount)
-{
-    if (amount >= tile.resource_amount)
-    {
-        amount -= tile.resource_amount;
-        tile.resource_amount = 0;
-        flipTileAndHandleEffects(tile);
-        return amount;
-    }
-    else
-    {
-        tile.resource_amount -= amount;
-    }
-    return 0;
-}
-void GameState::flipTileAndHandleEffects(Tile &tile)
+
+void GameState::flipTileAndHandleEffects(CityId city, int slotIndex)
 {
-    if (tile.flipped == true)
+    if (!m_board.flipTile(city, slotIndex))
+        return;
+    const Tile *tile = m_board.getPlacedTile(city, slotIndex);
+    auto playerIt = m_players.find(tile->owner);
+    if (playerIt == m_players.end())
         return;
-    tile.flipped = true;
-    auto playerIt = m_players.find(tile.owner);
-    playerIt->second->income_level += tile.income;
+    saveForUndo(*playerIt->second);
+    playerIt->second->income_level += tile->income;
+    m_changes.players.insert(tile->owner);
 }
 
-int GameState::chooseAndConsumeResources(Player &player, const std::string &cityName, TileType resourceType, int amountNeeded)
+int GameState::chooseAndConsumeResources(Player &player, CityId cityId, TileType resourceType, int amountNeeded)
 {
     if (amountNeeded == 0)
         return 0;
 
-    auto options = findAvailableResources(cityName, resourceType, player, amountNeeded);
-    if (options.empty())
-    {
-        return amountNeeded; // Not resources available
-    }
-
-    // If only one option, use it automatically
-    if (options.size() == 1)
+    // Options come in the order they have to be used
+    auto options = findAvailableResources(cityId, resourceType, player, amountNeeded);
+    for (const auto &option : options)
     {
-        auto city = m_board.getCity(options[0].cityName);
-        auto tile = city->slots[options[0].slotIndex].placedTile;
-        amountNeeded = consumeResources(*tile, amountNeeded);
-    }
-    else
-    {
-        auto city = m_board.getCity(options[0].cityName);
-        auto tile = city->slots[options[0].slotIndex].placedTile;
-        amountNeeded = consumeResources(*tile, amountNeeded);
-        if (amountNeeded > 0)
-        {
-            amountNeeded = chooseAndConsumeResources(player, cityName, resourceType, amountNeeded);
-        }
+        if (amountNeeded == 0)
+            break;
+        amountNeeded -= m_board.consumeResource(option.city, option.slotIndex, amountNeeded);
+        m_changes.slots.emplace(option.city, option.slotIndex);
+
+        const Tile *tile = m_board.getPlacedTile(option.city, option.slotIndex);
+        if (tile->resource_amount == 0 && tile->type != TileType::Merchant)
+            flipTileAndHandleEffects(option.city, option.slotIndex);
     }
 
     return amountNeeded;
@@ -281,83 +495,149 @@ int GameState::chooseAndConsumeResources(Player &player, const std::string &city
 
 bool GameState::handleTilePlacement(Player &player, const GameAction &action)
 {
-    Tile *tile = player.player_board.peekTile(action.tileType).get();
-    if (tile == nullptr)
+    TileDescriptor next = player.player_board.peekTile(action.tileType);
+    if (!next)
         return false;
+    Tile tile = next.makeTile();
     // Check if the tile can be placed on the board
-    if (!m_board.canPlaceTile(action.cityName, action.slotIndex, *tile))
+    if (!m_board.canPlaceTile(action.city, action.slotIndex, tile))
         return false;
 
     // Check if player has enough money
-    if (player.money < getTilePrice(action.cityName, *tile))
+    if (player.money < getTilePrice(action.city, tile))
         return false;
 
     // If all checks pass, place the tile and update player state
-    if (m_board.placeTile(action.cityName, action.slotIndex, *tile))
+    if (m_board.placeTile(action.city, action.slotIndex, tile))
     {
-        tile = player.player_board.takeTile(action.tileType).get();
-        player.money -= getTilePrice(action.cityName, *tile);
-        int coal_amount = chooseAndConsumeResources(player, action.cityName, TileType::Coal, tile->cost_coal);
-        int iron_amount = chooseAndConsumeResources(player, action.cityName, TileType::Iron, tile->cost_iron);
+        player.player_board.takeTile(action.tileType);
+        player.money -= getTilePrice(action.city, tile);
+        int coal_amount = chooseAndConsumeResources(player, action.city, TileType::Coal, tile.cost_coal);
+        int iron_amount = chooseAndConsumeResources(player, action.city, TileType::Iron, tile.cost_iron);
         coal_market.buy(coal_amount);
         iron_market.buy(iron_amount);
+        m_changes.slots.emplace(action.city, action.slotIndex);
+        m_changes.players.insert(player.id);
+        m_changes.markets = true;
         return true;
     }
     return false;
 }
 
+nlohmann::json GameState::playerToJson(const Player &player) const
+{
+    nlohmann::json playerJson = {
+        {"id", player.id},
+        {"score", player.score},
+        {"money", player.money},
+        {"income_level", player.income_level},
+        {"player_board", nlohmann::json::object()}};
+
+    // Add PlayerBoard status
+    nlohmann::json &boardJson = playerJson["player_board"];
+    boardJson["coal"] = player.player_board.getRemainingTileAmount(TileType::Coal);
+    boardJson["iron"] = player.player_board.getRemainingTileAmount(TileType::Iron);
+    boardJson["cotton"] = player.player_board.getRemainingTileAmount(TileType::Cotton);
+    boardJson["manufacturer"] = player.player_board.getRemainingTileAmount(TileType::Manufacturer);
+    boardJson["pottery"] = player.player_board.getRemainingTileAmount(TileType::Pottery);
+    boardJson["brewery"] = player.player_board.getRemainingTileAmount(TileType::Brewery);
+    return playerJson;
+}
+
+nlohmann::json GameState::tileToJson(const Tile *tile) const
+{
+    if (!tile)
+        return nullptr;
+    return {
+        {"type", tile->type},
+        {"owner", tile->owner},
+        {"level", tile->level},
+        {"flipped", tile->flipped},
+        {"resource_amount", tile->resource_amount},
+    };
+}
+
+nlohmann::json GameState::actionToJson(const GameAction &action) const
+{
+    switch (action.type)
+    {
+    case GameAction::Type::PlaceTile:
+        return {{"action", "placeTile"},
+                {"cityName", m_board.getCityName(action.city)},
+                {"slotIndex", action.slotIndex},
+                {"tileType", action.tileType}};
+    case GameAction::Type::PlaceLink:
+        return {{"action", "placeLink"},
+                {"cityName", m_board.getCityName(action.city)},
+                {"cityName2", m_board.getCityName(action.city2)}};
+    case GameAction::Type::Sell:
+        return {{"action", "sell"},
+                {"cityName", m_board.getCityName(action.city)},
+                {"slotIndex", action.slotIndex}};
+    case GameAction::Type::Develop:
+    {
+        nlohmann::json develop = {{"action", "develop"}, {"tileType", action.tileType}};
+        if (action.tileType2 != TileType::NullTile)
+            develop["tileType2"] = action.tileType2;
+        return develop;
+    }
+    case GameAction::Type::TakeLoan:
+        return {{"action", "takeLoan"}};
+    default:
+        return nullptr;
+    }
+}
+
+nlohmann::json GameState::marketsToJson() const
+{
+    return {
+        {"coal", {{"cubes", coal_market.getCubeCount()}, {"price", coal_market.getPrice(1)}}},
+        {"iron", {{"cubes", iron_market.getCubeCount()}, {"price", iron_market.getPrice(1)}}},
+    };
+}
+
+void GameState::advanceEra()
+{
+    if (era == ERA::RailRoad)
+        return;
+    era = ERA::RailRoad;
+    m_board.clearLinks();
+    clearUndo();
+    m_changes.links.clear();
+    m_changes.removedLinks.clear();
+    m_changes.era = true;
+}
+
+const char *GameState::eraName(ERA era)
+{
+    return era == ERA::Canal ? "canal" : "rail";
+}
+
 nlohmann::json GameState::getState() const
 {
     nlohmann::json state;
+    state["type"] = "state";
+    state["seq"] = m_seq;
+    state["era"] = eraName(era);
     state["players"] = nlohmann::json::array();
     for (const auto &pair : m_players)
     {
-        const auto &player = pair.second;
-        nlohmann::json playerJson = {
-            {"id", player->id},
-            {"score", player->score},
-            {"money", player->money},
-            {"income_level", player->income_level},
-            {"player_board", nlohmann::json::object()}};
-
-        // Add PlayerBoard status
-        nlohmann::json &boardJson = playerJson["player_board"];
-        boardJson["coal"] = player->player_board.getRemainingTileAmount(TileType::Coal);
-        boardJson["iron"] = player->player_board.getRemainingTileAmount(TileType::Iron);
-        boardJson["cotton"] = player->player_board.getRemainingTileAmount(TileType::Cotton);
-        boardJson["manufacturer"] = player->player_board.getRemainingTileAmount(TileType::Manufacturer);
-        boardJson["pottery"] = player->player_board.getRemainingTileAmount(TileType::Pottery);
-        boardJson["brewery"] = player->player_board.getRemainingTileAmount(TileType::Brewery);
-
-        state["players"].push_back(playerJson);
+        state["players"].push_back(playerToJson(*pair.second));
     }
 
     state["board"] = nlohmann::json::object();
-    for (const auto &pair : m_board.getCities())
+    for (CityId cityId = 0; cityId < static_cast<CityId>(m_board.getCityCount()); cityId++)
     {
-        const auto &cityPtr = pair.second;
+        const City *cityPtr = m_board.getCity(cityId);
+        if (!cityPtr)
+            continue;
         nlohmann::json cityJson = {
             {"slots", nlohmann::json::array()}};
-        for (const auto &slot : cityPtr->slots)
+        for (size_t slotIndex = 0; slotIndex < cityPtr->slots.size(); slotIndex++)
         {
             nlohmann::json slotJson;
-            if (slot.placedTile)
-            {
-                // Nested structure if placedTile exists
-                slotJson["placedTile"] = {
-                    {"type", slot.placedTile->type},
-                    {"owner", slot.placedTile->owner},
-                    {"level", slot.placedTile->level},
-                    {"flipped", slot.placedTile->flipped},
-                    {"resource_amount", slot.placedTile->resource_amount},
-                };
-            }
-            else
-            {
-                // No placedTile
-                slotJson["placedTile"] = nullptr;
-            }
-            slotJson["allowedTileTypes"] = slot.allowedTileTypes;
+            slotJson["placedTile"] = tileToJson(m_board.getPlacedTile(cityId, static_cast<int>(slotIndex)));
+            slotJson["allowedTileTypes"] = cityPtr->slots[slotIndex].allowedTileTypes;
             cityJson["slots"].push_back(slotJson);
         }
         state["board"]["cities"][cityPtr->name] = cityJson;
@@ -366,49 +646,89 @@ nlohmann::json GameState::getState() const
     state["connections"] = nlohmann::json::array();
     for (const auto &connection : m_board.getPlacedLinks())
     {
-        state["connections"].push_back({{"city1", connection.city1},
-                                        {"city2", connection.city2},
-                                        {"owner", connection.linkOwner ? connection.linkOwner->id : -1}});
+        state["connections"].push_back({{"city1", m_board.getCityName(connection.city1)},
+                                        {"city2", m_board.getCityName(connection.city2)},
+                                        {"owner", connection.linkOwner}});
     }
+    state["markets"] = marketsToJson();
 
-    // std::cout << state.dump(4) << std::endl; // `4` is the indentation level for pretty-printing
     return state;
 }
 
-void GameState::setupBoardForTesting(const GameBoard &board)
+nlohmann::json GameState::takeDelta()
 {
-    // Clear existing board
-    m_board = GameBoard();
+    nlohmann::json delta;
+    delta["type"] = "delta";
+    delta["seq"] = ++m_seq;
 
-    // Copy cities and their slots
-    for (const auto &[cityName, cityPtr] : board.getCities())
+    delta["players"] = nlohmann::json::array();
+    for (int id : m_changes.players)
     {
-        m_board.addCity(cityName);
-        for (const auto &slot : cityPtr->slots)
-        {
-            m_board.addSlot(cityName, slot);
-            if (slot.placedTile)
-            {
-                m_board.placeTile(cityName, m_board.getCity(cityName)->slots.size() - 1, *slot.placedTile);
-            }
-        }
+        auto it = m_players.find(id);
+        if (it != m_players.end())
+            delta["players"].push_back(playerToJson(*it->second));
     }
+    delta["removedPlayers"] = m_changes.removedPlayers;
 
-    // Copy connections
-    for (const auto &connection : board.getPlacedLinks())
+    delta["slots"] = nlohmann::json::array();
+    for (const auto &[cityId, slotIndex] : m_changes.slots)
     {
-        m_board.addConnection(connection.city1, connection.city2);
-        if (connection.linkOwner)
-        {
-            m_board.placeLink(connection.city1, connection.city2, connection.linkOwner);
-        }
+        const City *city = m_board.getCity(cityId);
+        if (!city || slotIndex < 0 || slotIndex >= static_cast<int>(city->slots.size()))
+            continue;
+        delta["slots"].push_back({{"city", city->name},
+                                  {"slotIndex", slotIndex},
+                                  {"placedTile", tileToJson(m_board.getPlacedTile(cityId, slotIndex))}});
+    }
+
+    // Clients drop all their links before applying this delta's connections
+    if (m_changes.era)
+        delta["era"] = eraName(era);
+
+    // Removed before this delta's connections are added
+    if (!m_changes.removedLinks.empty())
+    {
+        delta["removedConnections"] = nlohmann::json::array();
+        for (const auto &[city1, city2] : m_changes.removedLinks)
+            delta["removedConnections"].push_back({{"city1", m_board.getCityName(city1)},
+                                                   {"city2", m_board.getCityName(city2)}});
     }
+
+    delta["connections"] = nlohmann::json::array();
+    for (const auto &connection : m_board.getPlacedLinks())
+    {
+        if (m_changes.links.count({connection.city1, connection.city2}) == 0)
+            continue;
+        delta["connections"].push_back({{"city1", m_board.getCityName(connection.city1)},
+                                        {"city2", m_board.getCityName(connection.city2)},
+                                        {"owner", connection.linkOwner}});
+    }
+
+    if (m_changes.markets)
+        delta["markets"] = marketsToJson();
+
+    m_changes.clear();
+    return delta;
+}
+
+void GameState::setupBoardForTesting(const GameBoard &board)
+{
+    m_board = board;
+    m_board.setRecording(m_undoEnabled);
+    clearUndo();
 }
 
 bool GameState::handleDevelop(Player &player, const GameAction &action)
 {
     if (action.tileType == TileType::NullTile)
         return false;
+    // Both tiles have to be on the player board, two of them for a pair
+    // from the same pile
+    if (!player.player_board.hasTiles(action.tileType))
+        return false;
+    if (action.tileType2 != TileType::NullTile &&
+        player.player_board.getRemainingTileAmount(action.tileType2) < (action.tileType2 == action.tileType ? 2u : 1u))
+        return false;
     int spent_iron = (action.tileType2 == TileType::NullTile) ? 1 : 2;
     int cost = iron_market.getPrice(spent_iron);
     if (cost > player.money)
@@ -417,6 +737,8 @@ bool GameState::handleDevelop(Player &player, const GameAction &action)
     player.player_board.takeTile(action.tileType2);
     iron_market.buy(2);
     player.money -= cost;
+    m_changes.players.insert(player.id);
+    m_changes.markets = true;
     return true;
 }
 int continueSelling()
@@ -424,7 +746,7 @@ int continueSelling()
     return 0;
 }
 
-void printVector(const std::vector<std::pair<std::string, int>> &vec)
+void printVector(const std::vector<std::pair<CityId, int>> &vec)
 {
     for (const auto &p : vec)
     {
@@ -435,18 +757,17 @@ void printVector(const std::vector<std::pair<std::string, int>> &vec)
 bool GameState::handleSell(Player &player, const GameAction &action)
 {
     auto sellableTiles = m_board.findSellableTiles(player);
-    auto it = std::find(sellableTiles.begin(), sellableTiles.end(), std::make_pair(action.cityName, action.slotIndex));
+    auto it = std::find(sellableTiles.begin(), sellableTiles.end(), std::make_pair(action.city, action.slotIndex));
     if (it == sellableTiles.end())
     {
         return false;
     }
-    auto city = m_board.getCity(action.cityName);
-    auto &slot = city->slots[action.slotIndex];
-    auto tile = slot.placedTile;
+    const Tile *tile = m_board.getPlacedTile(action.city, action.slotIndex);
     // Update player's score and money
     // Consume beer
-    chooseAndConsumeResources(player, action.cityName, TileType::Brewery, tile->beer_demand);
-    flipTileAndHandleEffects(*tile);
+    chooseAndConsumeResources(player, action.city, TileType::Brewery, tile->beer_demand);
+    flipTileAndHandleEffects(action.city, action.slotIndex);
+    m_changes.slots.emplace(action.city, action.slotIndex);
     /*
     sellableTiles = m_board.findSellableTiles(player);
     if (sellableTiles.size() > 1)
@@ -458,13 +779,13 @@ bool GameState::handleSell(Player &player, const GameAction &action)
 bool GameState::handleLinkPlacement(Player &player, const GameAction &action)
 {
     static const int LINK_COST = 3;
-    if (m_board.isCityInPlayerNetwork(player, action.cityName) || m_board.isCityInPlayerNetwork(player, action.cityName2))
+    if (m_board.isCityInPlayerNetwork(player, action.city) || m_board.isCityInPlayerNetwork(player, action.city2))
     {
         if (player.money >= LINK_COST && era == ERA::Canal)
         {
             player.money -= LINK_COST;
         }
-        return m_board.placeLink(action.cityName, action.cityName2, std::make_shared<Player>(player));
+        return m_board.placeLink(action.city, action.city2, player.id);
     }
     return false;
 }
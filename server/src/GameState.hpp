@@ -1,7 +1,10 @@
 #ifndef GAMESTATE_HPP
 #define GAMESTATE_HPP
 
+#include <cstdint>
+#include <functional>
 #include <vector>
+#include <set>
 #include <unordered_map>
 #include <memory>
 #include <nlohmann/json.hpp>
@@ -19,11 +22,28 @@ enum class ERA
 
 struct ResourceOption
 {
-    std::string cityName;
+    CityId city;
     int slotIndex;
     int amount;
 };
 
+/// Parts of the state touched since the last delta was taken
+struct StateChanges
+{
+    std::set<std::pair<CityId, int>> slots;
+    std::set<std::pair<CityId, CityId>> links;
+    // Links taken back by an undo
+    std::set<std::pair<CityId, CityId>> removedLinks;
+    std::set<int> players;
+    std::set<int> removedPlayers;
+    bool markets = false;
+    // The era changed and every link was removed
+    bool era = false;
+
+    bool empty() const;
+    void clear();
+};
+
 class GameState
 {
 private:
@@ -32,26 +52,89 @@ private:
     Market coal_market{7, 2};
     Market iron_market{5, 2};
     ERA era = ERA::Canal;
+    uint64_t m_seq = 0;
+    StateChanges m_changes;
+
+    // How to revert one accepted action: where the board's undo log stood
+    // before it, the markets as they were, and the players it changed as
+    // they were, from m_undoPlayers[playersMark] on
+    struct ActionUndo
+    {
+        size_t boardMark;
+        size_t playersMark;
+        Market coal;
+        Market iron;
+    };
+    bool m_undoEnabled = false;
+    // The board's undo epoch the marks in m_undo belong to
+    uint64_t m_undoEpoch = 0;
+    std::vector<ActionUndo> m_undo;
+    std::vector<Player> m_undoPlayers;
 
 public:
     GameBoard m_board;
     GameState();
+    // Deep copy of the whole game: players, board, markets, era and pending
+    // changes. Cheap enough to copy per node of a search.
+    GameState(const GameState &other);
+    GameState &operator=(const GameState &other);
+    GameState(GameState &&) = default;
+    GameState &operator=(GameState &&) = default;
     std::shared_ptr<Player> addPlayer();
     void removePlayer(int id);
     bool handleAction(int playerId, const GameAction &action);
+    // Record every accepted action so it can be undone. Off by default;
+    // switching it either way starts an empty log. Anything that is not an
+    // action (players joining or leaving, a new era, editing m_board
+    // directly) also empties the log.
+    void setUndoEnabled(bool enabled);
+    size_t getUndoDepth() const { return m_undo.size(); }
+    // Revert the last count accepted actions, newest first, and report what
+    // they changed in the next delta. Returns how many were reverted.
+    size_t undo(size_t count = 1);
     bool handleTilePlacement(Player &player, const GameAction &action);
+    // Every action handleAction would accept from the player right now:
+    // tile placements, links, sells, develops and a loan, in that order. A
+    // develop of two different industries is listed in one order only.
+    // Board and market lookups are shared across candidates, so this is
+    // much cheaper than trying each action.
+    void forEachLegalAction(int playerId, const std::function<void(const GameAction &)> &visit) const;
+    std::vector<GameAction> getLegalActions(int playerId) const;
+    // The legal actions as a "legalMoves" message, in the format clients send them
+    nlohmann::json getLegalMoves(int playerId) const;
+    // Move from the canal to the rail era, clearing all placed links
+    void advanceEra();
+    ERA getEra() const { return era; }
+    // Full snapshot, tagged with the sequence number of the last delta
     nlohmann::json getState() const;
+    // Changes since the previous delta; advances the sequence number
+    nlohmann::json takeDelta();
+    bool hasPendingChanges() const { return !m_changes.empty(); }
+    uint64_t getSequence() const { return m_seq; }
 
     void setupBoardForTesting(const GameBoard &board);
 
 private:
-    std::vector<ResourceOption> findAvailableResources(const std::string &startCity, TileType resourceType, Player &player, int amountNeeded) const;
-    int chooseAndConsumeResources(Player &player, const std::string &cityName, TileType resourceType, int amountNeeded);
-    int getTilePrice(const std::string &cityName, const Tile tile);
-    void flipTileAndHandleEffects(Tile &tile);
+    nlohmann::json playerToJson(const Player &player) const;
+    nlohmann::json tileToJson(const Tile *tile) const;
+    nlohmann::json marketsToJson() const;
+    nlohmann::json actionToJson(const GameAction &action) const;
+    static const char *eraName(ERA era);
+    bool applyAction(Player &player, const GameAction &action);
+    // Keep the player as it was before the action being recorded
+    void saveForUndo(const Player &player);
+    // Drop every recorded action, along with the board's log
+    void clearUndo();
+    // clearUndo if the board discarded its log behind our back
+    void checkUndoEpoch();
+    std::vector<ResourceOption> findAvailableResources(CityId startCity, TileType resourceType, Player &player, int amountNeeded) const;
+    int chooseAndConsumeResources(Player &player, CityId city, TileType resourceType, int amountNeeded);
+    int getTilePrice(CityId city, const Tile &tile) const;
+    // getTilePrice given the coal and merchants reachable from the city
+    int tilePrice(const Tile &tile, int coalInReach, bool merchantInReach) const;
+    void flipTileAndHandleEffects(CityId city, int slotIndex);
     bool handleDevelop(Player &player, const GameAction &action);
     bool handleSell(Player &player, const GameAction &action);
-    int consumeResources(Tile &tile, int amount);
     bool handleLinkPlacement(Player &player, const GameAction &action);
     // Add any private helper methods here if needed
 };
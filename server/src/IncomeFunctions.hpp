@@ -1,12 +1,79 @@
 #ifndef INCOME_FUNCTIONS_HPP
 #define INCOME_FUNCTIONS_HPP
 
-// Global income table declaration
+#include <array>
+#include <vector>
+
+const int MIN_INCOME_LEVEL = 0;
+const int MAX_INCOME_LEVEL = 99;
+const int MIN_INCOME = -10;
+const int MAX_INCOME = 30;
+
+// Income printed on the track at a level, MIN_INCOME_LEVEL..MAX_INCOME_LEVEL
+constexpr int incomeAtLevel(int level) {
+    // Levels 0 to 10: income increases by 1 per level
+    if (level <= 10) return level - 10;
+    // Levels 11 to 30: income increases by 1 for every 2 levels
+    if (level <= 30) return (level - 10 + 1) / 2;
+    // Levels 31 to 60: income increases by 1 for every 3 levels
+    if (level <= 60) return 10 + (level - 30 + 2) / 3;
+    // Levels 61 to 99: income increases by 1 for every 4 levels
+    return 20 + (level - 60 + 3) / 4;
+}
+
+constexpr std::array<int, MAX_INCOME_LEVEL + 1> makeIncomeTable() {
+    std::array<int, MAX_INCOME_LEVEL + 1> table{};
+    for (int level = MIN_INCOME_LEVEL; level <= MAX_INCOME_LEVEL; ++level) {
+        table[level] = incomeAtLevel(level);
+    }
+    return table;
+}
+
+// Lowest level paying at least each income, indexed by income - MIN_INCOME
+constexpr std::array<int, MAX_INCOME - MIN_INCOME + 1> makeLevelTable() {
+    std::array<int, MAX_INCOME - MIN_INCOME + 1> table{};
+    for (int level = MAX_INCOME_LEVEL; level >= MIN_INCOME_LEVEL; --level) {
+        for (int income = MIN_INCOME; income <= incomeAtLevel(level); ++income) {
+            table[income - MIN_INCOME] = level;
+        }
+    }
+    return table;
+}
+
+constexpr std::array<int, MAX_INCOME_LEVEL + 1> INCOME_TABLE = makeIncomeTable();
+constexpr std::array<int, MAX_INCOME - MIN_INCOME + 1> LEVEL_TABLE = makeLevelTable();
+
+static_assert(INCOME_TABLE[MIN_INCOME_LEVEL] == MIN_INCOME && INCOME_TABLE[MAX_INCOME_LEVEL] == MAX_INCOME,
+              "income track runs from -10 to 30");
+static_assert(INCOME_TABLE[30] == 10 && INCOME_TABLE[60] == 20, "income track changes step at 30 and 60");
+
+// Income at a level, clamped to the ends of the track
+constexpr int incomeFor(int level) noexcept {
+    return INCOME_TABLE[level < MIN_INCOME_LEVEL ? MIN_INCOME_LEVEL
+                        : level > MAX_INCOME_LEVEL ? MAX_INCOME_LEVEL : level];
+}
+
+// Lowest level with at least this income, clamped to the ends of the track
+constexpr int levelForIncome(int income) noexcept {
+    return LEVEL_TABLE[(income < MIN_INCOME ? MIN_INCOME : income > MAX_INCOME ? MAX_INCOME : income) - MIN_INCOME];
+}
+
+// Level after a loan: the highest level paying 3 less. -1 when the level is
+// off the track or the loan would go below it.
+constexpr int loanLevel(int level) noexcept {
+    if (level < MIN_INCOME_LEVEL || level > MAX_INCOME_LEVEL) return -1;
+    int income = INCOME_TABLE[level] - 2;
+    return income < MIN_INCOME ? -1 : LEVEL_TABLE[income - MIN_INCOME] - 1;
+}
 
 // Function to get income for a given level
- int getIncome(unsigned int income_level);
+int getIncome(unsigned int income_level);
 
 // Function to take a loan and return the new income level
 unsigned int takeLoan(unsigned int income_level);
 
-#endif // INCOME_FUNCTIONS_HPP
\ No newline at end of file
+// incomeFor and loanLevel over every player at once
+std::vector<int> getIncomes(const std::vector<int>& income_levels);
+std::vector<int> takeLoans(const std::vector<int>& income_levels);
+
+#endif // INCOME_FUNCTIONS_HPP
@@ -0,0 +1,172 @@
+#include "Logger.hpp"
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+    const size_t LOG_BUFFER_CAPACITY = 8192;
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : m_buffer(LOG_BUFFER_CAPACITY) {}
+
+Logger::~Logger() {
+    stop();
+}
+
+void Logger::log(LogLevel level, const char* component, std::string message) {
+    Record record;
+    record.level = level;
+    record.component = component;
+    record.time = std::chrono::system_clock::now();
+    record.thread = std::this_thread::get_id();
+    record.message = std::move(message);
+
+    if (!m_running.load(std::memory_order_acquire)) {
+        write(record);
+        return;
+    }
+    if (!m_buffer.tryPush(std::move(record))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // Pairs with the fence in waitForRecords(): either the writer sees this
+    // record before parking or we see it parked and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_parked.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wake.notify_one();
+    } else if (!m_running.load(std::memory_order_acquire)) {
+        // stop() raced with this call and may already have done its final
+        // drain; flush the record ourselves rather than leave it queued
+        drain();
+    }
+}
+
+void Logger::start() {
+    bool expected = false;
+    if (m_running.compare_exchange_strong(expected, true)) {
+        m_writer = std::thread(&Logger::writerLoop, this);
+    }
+}
+
+void Logger::stop() {
+    bool expected = true;
+    if (m_running.compare_exchange_strong(expected, false) && m_writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_wake.notify_one();
+        }
+        m_writer.join();
+        // Anything pushed between the writer's last drain and its exit
+        drain();
+    }
+}
+
+bool Logger::drain() {
+    Record record;
+    bool wrote = false;
+    while (m_buffer.tryPop(record)) {
+        write(record);
+        wrote = true;
+    }
+    if (wrote) {
+        std::cout.flush();
+    }
+    return wrote;
+}
+
+void Logger::waitForRecords() {
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_parked.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Re-check under the lock so a push or stop() between the writer's last
+    // drain and here cannot be missed; their notify needs this mutex
+    if (m_running.load(std::memory_order_acquire) && m_buffer.empty()) {
+        m_wake.wait(lock);
+    }
+    m_parked.store(false, std::memory_order_relaxed);
+}
+
+void Logger::writerLoop() {
+    uint64_t reportedDrops = 0;
+    for (;;) {
+        bool running = m_running.load(std::memory_order_acquire);
+        bool wrote = drain();
+
+        uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != reportedDrops) {
+            Record warning;
+            warning.level = LogLevel::Warn;
+            warning.component = "log";
+            warning.time = std::chrono::system_clock::now();
+            warning.thread = std::this_thread::get_id();
+            warning.message = "dropped " + std::to_string(dropped - reportedDrops) + " log records";
+            write(warning);
+            reportedDrops = dropped;
+        }
+
+        if (!wrote) {
+            if (!running) {
+                break; // stopped and drained
+            }
+            waitForRecords();
+        }
+    }
+}
+
+void Logger::write(const Record& record) {
+    std::ostream& out = record.level >= LogLevel::Warn ? std::cerr : std::cout;
+    out << format(record) << '\n';
+}
+
+const char* Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "trace";
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warn: return "warn";
+        case LogLevel::Error: return "error";
+        case LogLevel::Off: return "off";
+    }
+    return "unknown";
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    for (LogLevel candidate : {LogLevel::Trace, LogLevel::Debug, LogLevel::Info, LogLevel::Warn, LogLevel::Error, LogLevel::Off}) {
+        if (name == levelName(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string Logger::format(const Record& record) {
+    // logfmt: time=... level=... component=... thread=... msg="..."
+    std::time_t seconds = std::chrono::system_clock::to_time_t(record.time);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(record.time.time_since_epoch()).count() % 1000;
+    std::tm utc{};
+    gmtime_r(&seconds, &utc);
+
+    std::ostringstream line;
+    line << "time=" << std::put_time(&utc, "%Y-%m-%dT%H:%M:%S") << '.' << std::setw(3) << std::setfill('0') << millis << 'Z'
+         << " level=" << levelName(record.level)
+         << " component=" << record.component
+         << " thread=" << record.thread
+         << " msg=\"";
+    for (char c : record.message) {
+        switch (c) {
+            case '"': line << "\\\""; break;
+            case '\\': line << "\\\\"; break;
+            case '\n': line << "\\n"; break;
+            default: line << c; break;
+        }
+    }
+    line << '"';
+    return line.str();
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "RingBuffer.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+enum class LogLevel : int {
+    Trace = 0,
+    Debug = 1,
+    Info = 2,
+    Warn = 3,
+    Error = 4,
+    Off = 5
+};
+
+// Statements below this level are compiled out entirely
+#ifndef BRASS_LOG_COMPILE_LEVEL
+#define BRASS_LOG_COMPILE_LEVEL 0
+#endif
+
+/// Asynchronous logger. Call sites format a record only when its level is
+/// enabled, then push it into a lock-free ring buffer; a background thread
+/// does all console I/O. Records are dropped (and counted) if the buffer is
+/// full rather than stalling the caller. An idle writer parks on a condition
+/// variable; producers only touch the mutex to wake it.
+class Logger {
+public:
+    struct Record {
+        LogLevel level = LogLevel::Info;
+        const char* component = "";
+        std::chrono::system_clock::time_point time;
+        std::thread::id thread;
+        std::string message;
+    };
+
+    static Logger& instance();
+
+    void setLevel(LogLevel level) { m_level.store(static_cast<int>(level), std::memory_order_relaxed); }
+    LogLevel getLevel() const { return static_cast<LogLevel>(m_level.load(std::memory_order_relaxed)); }
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= m_level.load(std::memory_order_relaxed);
+    }
+
+    void log(LogLevel level, const char* component, std::string message);
+
+    // Start/stop the background writer. Until start() is called records are
+    // written synchronously by the caller.
+    void start();
+    void stop();
+
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    static const char* levelName(LogLevel level);
+    // Accepts "trace", "debug", "info", "warn", "error" and "off"
+    static bool parseLevel(const std::string& name, LogLevel& level);
+    static std::string format(const Record& record);
+
+    ~Logger();
+
+private:
+    Logger();
+    void writerLoop();
+    // Write out everything queued; returns whether anything was written
+    bool drain();
+    void waitForRecords();
+    static void write(const Record& record);
+
+    std::atomic<int> m_level{static_cast<int>(LogLevel::Info)};
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_parked{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<uint64_t> m_dropped{0};
+    RingBuffer<Record> m_buffer;
+    std::thread m_writer;
+};
+
+#define BRASS_LOG(level, component, expr)                                                                  \
+    do {                                                                                                   \
+        if (static_cast<int>(level) >= BRASS_LOG_COMPILE_LEVEL && Logger::instance().isEnabled(level)) { \
+            std::ostringstream brass_log_stream;                                                           \
+            brass_log_stream << expr;                                                                      \
+            Logger::instance().log(level, component, brass_log_stream.str());                              \
+        }                                                                                                  \
+    } while (0)
+
+#define LOG_TRACE(component, expr) BRASS_LOG(LogLevel::Trace, component, expr)
+#define LOG_DEBUG(component, expr) BRASS_LOG(LogLevel::Debug, component, expr)
+#define LOG_INFO(component, expr) BRASS_LOG(LogLevel::Info, component, expr)
+#define LOG_WARN(component, expr) BRASS_LOG(LogLevel::Warn, component, expr)
+#define LOG_ERROR(component, expr) BRASS_LOG(LogLevel::Error, component, expr)
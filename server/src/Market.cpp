@@ -1,94 +1,64 @@
 #include "Market.hpp"
+#include <algorithm>
 #include <iostream>
 
-Market::Market(int maxPrice, int slotsPerPrice) : maxPrice(maxPrice) {
-    priceTrack.resize(maxPrice);
-    cubesAtPrice.resize(maxPrice, slotsPerPrice);
-    for (int i = 0; i < maxPrice; ++i) {
-        priceTrack[i] = i + 1;
-    }
+Market::Market(int maxPrice, int slotsPerPrice)
+    : maxPrice(maxPrice), slotsPerPrice(slotsPerPrice), cubes(maxPrice * slotsPerPrice) {}
+
+int Market::prefixCost(int slots) const {
+    // Slot j, counted from the cheap end, costs j / slotsPerPrice + 1
+    int fullPrices = slots / slotsPerPrice;
+    int rest = slots % slotsPerPrice;
+    return slotsPerPrice * fullPrices * (fullPrices + 1) / 2 + rest * (fullPrices + 1);
 }
 
 int Market::getPrice(int quantity) const {
-    int totalCost = 0;
-    int remainingQuantity = quantity;
-    std::vector<int> tempCubesAtPrice = cubesAtPrice;  // Create a temporary copy
-
-    for (int i = 0; i < maxPrice && remainingQuantity > 0; ++i) {
-        while (tempCubesAtPrice[i] > 0 && remainingQuantity > 0) {
-            totalCost += priceTrack[i];
-            tempCubesAtPrice[i]--;
-            remainingQuantity--;
-        }
+    if (quantity <= 0) {
+        return 0;
     }
+    // The cheapest cube sits in slot capacity() - cubes
+    int firstSlot = capacity() - cubes;
+    int fromMarket = std::min(quantity, cubes);
+    int totalCost = prefixCost(firstSlot + fromMarket) - prefixCost(firstSlot);
 
     // If there are not enough cubes in the market, use the highest price for the remaining quantity
-    if (remainingQuantity > 0) {
-        totalCost += remainingQuantity * (maxPrice + 1);
+    totalCost += (quantity - fromMarket) * (maxPrice + 1);
+    return totalCost;
+}
+
+std::vector<int> Market::getPrices(const std::vector<int> &quantities) const {
+    std::vector<int> prices;
+    prices.reserve(quantities.size());
+    for (int quantity : quantities) {
+        prices.push_back(getPrice(quantity));
     }
+    return prices;
+}
 
-    return totalCost;
+int Market::getCubeCount() const {
+    return cubes;
 }
 
 int Market::buy(int quantity) {
-    int totalCost = 0;
-    for (int i = 0; i < quantity; ++i) {
-        int price = getCurrentPrice();
-        totalCost += price;
-        removeCube(price);
-    }
+    int totalCost = getPrice(quantity);
+    cubes -= std::min(std::max(quantity, 0), cubes);
     return totalCost;
 }
 
 std::pair<int, int> Market::sell(int quantity) {
-    int itemsSold = 0;
-    int totalRevenue = 0;
-    while (itemsSold < quantity) {
-        int price = getHighestEmptySlot();
-        if (price == 0) {
-            break;  // Market is full, stop selling
-        }
-        totalRevenue += price;
-        addCube(price);
-        itemsSold++;
-    }
+    // Cubes go into the most expensive empty slots, right below the cheapest cube
+    int firstSlot = capacity() - cubes;
+    int itemsSold = std::min(std::max(quantity, 0), firstSlot);
+    int totalRevenue = prefixCost(firstSlot) - prefixCost(firstSlot - itemsSold);
+    cubes += itemsSold;
     return std::make_pair(itemsSold, totalRevenue);
 }
 
 void Market::printMarketState() const {
-    for (int i = maxPrice - 1; i >= 0; --i) {
-        std::cout << "Price " << priceTrack[i] << ": " << cubesAtPrice[i] << " cubes" << std::endl;
+    int firstSlot = capacity() - cubes;
+    for (int price = maxPrice; price >= 1; --price) {
+        int slotEnd = price * slotsPerPrice;
+        int cubesAtPrice = std::max(0, std::min(slotsPerPrice, slotEnd - firstSlot));
+        std::cout << "Price " << price << ": " << cubesAtPrice << " cubes" << std::endl;
     }
 }
-
-int Market::getCurrentPrice() const {
-    for (int i = 0; i < maxPrice; ++i) {
-        if (cubesAtPrice[i] > 0) {
-            return priceTrack[i];
-        }
-    }
-    return maxPrice+1; // Market is empty
-}
-
-int Market::getHighestEmptySlot() const {
-    for (int i = maxPrice - 1; i >= 0; --i) {
-        if (cubesAtPrice[i] < 2) {
-            return priceTrack[i];
-        }
-    }
-    return 0; // Market is full
-}
-
-void Market::removeCube(int price) {
-    int index = price - 1;
-    if (index >= 0 && index < maxPrice && cubesAtPrice[index] > 0) {
-        cubesAtPrice[index]--;
-    }
-}
-
-void Market::addCube(int price) {
-    int index = price - 1;
-    if (index >= 0 && index < maxPrice && cubesAtPrice[index] < 2) {
-        cubesAtPrice[index]++;
-    }
-}
\ No newline at end of file
@@ -4,23 +4,30 @@
 #include <vector>
 #include <utility>
 
+/// Coal or iron market track. Cubes are bought from the cheapest slots and
+/// sold into the most expensive empty ones, so the cubes always fill the top
+/// of the track and their count alone describes the market. Prices come from
+/// closed-form prefix sums over that track.
 class Market {
 private:
-    std::vector<int> priceTrack;
-    std::vector<int> cubesAtPrice;
     int maxPrice;
+    int slotsPerPrice;
+    int cubes;
 
-    int getCurrentPrice() const;
-    int getHighestEmptySlot() const;
-    void removeCube(int price);
-    void addCube(int price);
+    int capacity() const { return maxPrice * slotsPerPrice; }
+    // Sum of the prices of the lowest `slots` slots of the track
+    int prefixCost(int slots) const;
 
 public:
     Market(int maxPrice, int slotsPerPrice);
+    // Cost of buying quantity cubes; cubes beyond the market cost maxPrice + 1
     int getPrice(int quantity) const;
+    // getPrice for each quantity, without changing the market
+    std::vector<int> getPrices(const std::vector<int> &quantities) const;
+    int getCubeCount() const;
     int buy(int quantity);
     std::pair<int, int> sell(int quantity);
     void printMarketState() const;
 };
 
-#endif // MARKET_HPP
\ No newline at end of file
+#endif // MARKET_HPP
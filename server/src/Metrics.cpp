@@ -0,0 +1,174 @@
+#include "Metrics.hpp"
+#include <cstdio>
+#include <limits>
+#include <sstream>
+
+namespace {
+    int highestBit(uint64_t value) {
+        return 63 - __builtin_clzll(value);
+    }
+
+    void writeSeconds(std::ostringstream& out, uint64_t nanoseconds) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", nanoseconds / 1e9);
+        out << buffer;
+    }
+
+    void writeHistogram(std::ostringstream& out, const char* name, const char* help, const Histogram& histogram) {
+        out << "# HELP " << name << " " << help << "\n";
+        out << "# TYPE " << name << " histogram\n";
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < Histogram::BUCKET_COUNT; ++i) {
+            cumulative += histogram.bucketCount(i);
+            out << name << "_bucket{le=\"";
+            if (i + 1 == Histogram::BUCKET_COUNT) {
+                out << "+Inf";
+            } else {
+                writeSeconds(out, Histogram::upperBound(i));
+            }
+            out << "\"} " << cumulative << "\n";
+        }
+        out << name << "_sum ";
+        writeSeconds(out, histogram.sum());
+        out << "\n" << name << "_count " << cumulative << "\n";
+    }
+
+    void writeCounter(std::ostringstream& out, const char* name, const char* type, const char* help, uint64_t value) {
+        out << "# HELP " << name << " " << help << "\n";
+        out << "# TYPE " << name << " " << type << "\n";
+        out << name << " " << value << "\n";
+    }
+}
+
+void Histogram::record(uint64_t nanoseconds) {
+    m_buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void Histogram::record(std::chrono::steady_clock::duration duration) {
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    record(nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0);
+}
+
+size_t Histogram::bucketIndex(uint64_t nanoseconds) {
+    if (nanoseconds <= (uint64_t(1) << MIN_EXPONENT)) {
+        return 0;
+    }
+    // Upper bounds are inclusive, so classify value - 1
+    uint64_t value = nanoseconds - 1;
+    int exponent = highestBit(value);
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    size_t sub = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return 1 + (exponent - MIN_EXPONENT) * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::upperBound(size_t bucket) {
+    if (bucket == 0) {
+        return uint64_t(1) << MIN_EXPONENT;
+    }
+    if (bucket >= BUCKET_COUNT - 1) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    int exponent = MIN_EXPONENT + static_cast<int>((bucket - 1) / SUB_BUCKETS);
+    uint64_t sub = (bucket - 1) % SUB_BUCKETS + 1;
+    return (uint64_t(1) << exponent) + sub * (uint64_t(1) << (exponent - SUB_BUCKET_BITS));
+}
+
+uint64_t Histogram::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * total + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        cumulative += bucketCount(i);
+        if (cumulative >= rank) {
+            return upperBound(i);
+        }
+    }
+    return upperBound(BUCKET_COUNT - 1);
+}
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+void Metrics::connectionOpened() {
+    m_connections.fetch_add(1, std::memory_order_relaxed);
+    m_connections_total.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::connectionClosed() {
+    m_connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Metrics::setRoomCount(size_t rooms) {
+    m_rooms.store(rooms, std::memory_order_relaxed);
+}
+
+void Metrics::messageIn(size_t bytes) {
+    m_messages_in.fetch_add(1, std::memory_order_relaxed);
+    m_bytes_in.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Metrics::messageOut(size_t bytes) {
+    m_messages_out.fetch_add(1, std::memory_order_relaxed);
+    m_bytes_out.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Metrics::messageDropped() {
+    m_messages_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::actionHandled(GameAction::Type type, bool accepted) {
+    auto& counters = accepted ? m_accepted : m_rejected;
+    counters[static_cast<size_t>(type)].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Metrics::actionCount(GameAction::Type type, bool accepted) const {
+    const auto& counters = accepted ? m_accepted : m_rejected;
+    return counters[static_cast<size_t>(type)].load(std::memory_order_relaxed);
+}
+
+std::string Metrics::prometheus() const {
+    std::ostringstream out;
+    int64_t connections = m_connections.load(std::memory_order_relaxed);
+    writeCounter(out, "brass_connections", "gauge", "Open WebSocket connections.",
+                 connections > 0 ? static_cast<uint64_t>(connections) : 0);
+    writeCounter(out, "brass_connections_total", "counter", "WebSocket connections accepted.",
+                 m_connections_total.load(std::memory_order_relaxed));
+    writeCounter(out, "brass_rooms", "gauge", "Live game rooms.", m_rooms.load(std::memory_order_relaxed));
+    writeCounter(out, "brass_messages_in_total", "counter", "Messages received.",
+                 m_messages_in.load(std::memory_order_relaxed));
+    writeCounter(out, "brass_messages_out_total", "counter", "Messages queued for sending.",
+                 m_messages_out.load(std::memory_order_relaxed));
+    writeCounter(out, "brass_bytes_in_total", "counter", "Payload bytes received.",
+                 m_bytes_in.load(std::memory_order_relaxed));
+    writeCounter(out, "brass_bytes_out_total", "counter", "Payload bytes queued for sending, before compression.",
+                 m_bytes_out.load(std::memory_order_relaxed));
+    writeCounter(out, "brass_messages_dropped_total", "counter", "Messages dropped by the inbound rate limit.",
+                 m_messages_dropped.load(std::memory_order_relaxed));
+
+    out << "# HELP brass_actions_total Game actions handled, by type and result.\n";
+    out << "# TYPE brass_actions_total counter\n";
+    for (size_t i = 0; i < ACTION_TYPES; ++i) {
+        auto type = static_cast<GameAction::Type>(i);
+        out << "brass_actions_total{type=\"" << toString(type) << "\",result=\"accepted\"} "
+            << actionCount(type, true) << "\n";
+        out << "brass_actions_total{type=\"" << toString(type) << "\",result=\"rejected\"} "
+            << actionCount(type, false) << "\n";
+    }
+
+    writeHistogram(out, "brass_parse_seconds", "Time to decode an inbound message into a GameAction.", m_parse);
+    writeHistogram(out, "brass_handle_action_seconds", "Time spent in GameState::handleAction.", m_action);
+    writeHistogram(out, "brass_broadcast_seconds", "Time to encode and queue one state broadcast.", m_broadcast);
+    return out.str();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "GameAction.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/// Lock-free latency histogram with HDR-style log-linear buckets: every
+/// power of two between 1us and ~68s is split into four linear sub-buckets,
+/// so any recorded value is reported within 25% of its true magnitude.
+class Histogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 2;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MIN_EXPONENT = 10;
+    static constexpr int MAX_EXPONENT = 36;
+    // One bucket up to 2^MIN_EXPONENT, the log-linear range, then overflow
+    static constexpr size_t BUCKET_COUNT = 1 + (MAX_EXPONENT - MIN_EXPONENT) * SUB_BUCKETS + 1;
+
+    void record(uint64_t nanoseconds);
+    void record(std::chrono::steady_clock::duration duration);
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t bucketCount(size_t bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding quantile q (0..1), 0 when empty
+    uint64_t percentile(double q) const;
+
+    static size_t bucketIndex(uint64_t nanoseconds);
+    // Inclusive upper bound in nanoseconds, UINT64_MAX for the overflow bucket
+    static uint64_t upperBound(size_t bucket);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets{};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+};
+
+/// Records the time between construction and destruction into a histogram
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { m_histogram.record(std::chrono::steady_clock::now() - m_start); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/// Process-wide server counters, rendered in the Prometheus text exposition
+/// format. Rates (messages per second etc.) are left to the scraper, every
+/// traffic figure is a monotonic counter.
+class Metrics {
+public:
+    static Metrics& instance();
+
+    void connectionOpened();
+    void connectionClosed();
+    void setRoomCount(size_t rooms);
+
+    void messageIn(size_t bytes);
+    void messageOut(size_t bytes);
+    void messageDropped();
+
+    void actionHandled(GameAction::Type type, bool accepted);
+    uint64_t actionCount(GameAction::Type type, bool accepted) const;
+
+    Histogram& parseLatency() { return m_parse; }
+    Histogram& actionLatency() { return m_action; }
+    Histogram& broadcastLatency() { return m_broadcast; }
+
+    std::string prometheus() const;
+
+private:
+    static constexpr size_t ACTION_TYPES = static_cast<size_t>(GameAction::Type::Unknown) + 1;
+
+    std::atomic<int64_t> m_connections{0};
+    std::atomic<uint64_t> m_connections_total{0};
+    std::atomic<uint64_t> m_rooms{0};
+    std::atomic<uint64_t> m_messages_in{0};
+    std::atomic<uint64_t> m_messages_out{0};
+    std::atomic<uint64_t> m_bytes_in{0};
+    std::atomic<uint64_t> m_bytes_out{0};
+    std::atomic<uint64_t> m_messages_dropped{0};
+    std::array<std::atomic<uint64_t>, ACTION_TYPES> m_accepted{};
+    std::array<std::atomic<uint64_t>, ACTION_TYPES> m_rejected{};
+
+    Histogram m_parse;
+    Histogram m_action;
+    Histogram m_broadcast;
+};
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <websocketpp/extensions/extension.hpp>
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+#include <websocketpp/http/constants.hpp>
+#include <zlib.h>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+/// permessage-deflate parameters for the connections that negotiate the
+/// extension.
+struct DeflateSettings {
+    bool enabled = true;
+    // zlib compression level, 0 (none) to 9 (best)
+    int level = Z_DEFAULT_COMPRESSION;
+    // Reset the compressor after every message. Costs ratio, saves the
+    // per-connection 32KiB+ deflate window between messages.
+    bool server_no_context_takeover = false;
+    // LZ77 window we compress with, 9..15
+    int server_max_window_bits = 15;
+    // zlib memLevel, 1..9
+    int mem_level = 8;
+
+    bool operator==(const DeflateSettings& other) const {
+        return enabled == other.enabled && level == other.level &&
+               server_no_context_takeover == other.server_no_context_takeover &&
+               server_max_window_bits == other.server_max_window_bits && mem_level == other.mem_level;
+    }
+    bool operator!=(const DeflateSettings& other) const { return !(*this == other); }
+};
+
+/// Write-once home for the settings an endpoint's extensions start from.
+/// websocketpp default-constructs one extension per connection on the io
+/// threads, so the endpoint publishes its settings here before it accepts
+/// and every later read is a lock-free load.
+class DeflateSettingsSlot {
+public:
+    DeflateSettingsSlot() = default;
+    DeflateSettingsSlot(const DeflateSettingsSlot&) = delete;
+    DeflateSettingsSlot& operator=(const DeflateSettingsSlot&) = delete;
+    ~DeflateSettingsSlot() { delete m_settings.load(std::memory_order_relaxed); }
+
+    // Returns false if different settings were already published
+    bool publish(const DeflateSettings& settings) {
+        std::unique_ptr<DeflateSettings> fresh(new DeflateSettings(settings));
+        const DeflateSettings* expected = nullptr;
+        if (m_settings.compare_exchange_strong(expected, fresh.get(), std::memory_order_acq_rel)) {
+            fresh.release();
+            return true;
+        }
+        return *expected == settings;
+    }
+
+    // The published settings, or the defaults if nothing was published
+    const DeflateSettings& get() const {
+        static const DeflateSettings defaults;
+        const DeflateSettings* settings = m_settings.load(std::memory_order_acquire);
+        return settings ? *settings : defaults;
+    }
+
+private:
+    std::atomic<const DeflateSettings*> m_settings{nullptr};
+};
+
+/// permessage-deflate (RFC 7692) extension for websocketpp processors. Plays
+/// the same role as websocketpp's own permessage_deflate::enabled but takes
+/// its compression level, window size and context takeover from
+/// DeflateSettings instead of hard-coded defaults. The default constructor,
+/// used by websocketpp, copies them from config::settings(), a
+/// DeflateSettingsSlot.
+template <typename config>
+class PerMessageDeflate {
+public:
+    typedef websocketpp::extensions::permessage_deflate::error::value error_value;
+
+    PerMessageDeflate() : PerMessageDeflate(config::settings().get()) {}
+
+    explicit PerMessageDeflate(const DeflateSettings& settings)
+        : m_settings(settings),
+          m_enabled(false),
+          m_initialized(false),
+          m_server_no_context_takeover(false),
+          m_client_no_context_takeover(false),
+          m_server_max_window_bits(15),
+          m_compress_buffer_size(16384) {
+        m_dstate.zalloc = Z_NULL;
+        m_dstate.zfree = Z_NULL;
+        m_dstate.opaque = Z_NULL;
+        m_istate.zalloc = Z_NULL;
+        m_istate.zfree = Z_NULL;
+        m_istate.opaque = Z_NULL;
+        m_istate.avail_in = 0;
+        m_istate.next_in = Z_NULL;
+    }
+
+    ~PerMessageDeflate() {
+        if (!m_initialized) {
+            return;
+        }
+        deflateEnd(&m_dstate);
+        inflateEnd(&m_istate);
+    }
+
+    PerMessageDeflate(const PerMessageDeflate&) = delete;
+    PerMessageDeflate& operator=(const PerMessageDeflate&) = delete;
+
+    bool is_implemented() const { return m_settings.enabled; }
+    bool is_enabled() const { return m_enabled; }
+
+    // Server only, we never send offers
+    std::string generate_offer() const { return ""; }
+
+    websocketpp::lib::error_code validate_offer(websocketpp::http::attribute_list const&) {
+        return make_error(websocketpp::extensions::permessage_deflate::error::general);
+    }
+
+    websocketpp::err_str_pair negotiate(websocketpp::http::attribute_list const& offer) {
+        using namespace websocketpp::extensions::permessage_deflate;
+        websocketpp::err_str_pair ret;
+
+        m_server_no_context_takeover = m_settings.server_no_context_takeover;
+        m_client_no_context_takeover = false;
+        m_server_max_window_bits = clampWindowBits(m_settings.server_max_window_bits);
+
+        for (const auto& attribute : offer) {
+            if (attribute.first == "server_no_context_takeover") {
+                if (!attribute.second.empty()) {
+                    ret.first = make_error(error::invalid_attribute_value);
+                    return ret;
+                }
+                m_server_no_context_takeover = true;
+            } else if (attribute.first == "client_no_context_takeover") {
+                if (!attribute.second.empty()) {
+                    ret.first = make_error(error::invalid_attribute_value);
+                    return ret;
+                }
+                m_client_no_context_takeover = true;
+            } else if (attribute.first == "server_max_window_bits") {
+                int bits = std::atoi(attribute.second.c_str());
+                // zlib cannot produce raw deflate streams with a 256 byte window
+                if (bits < 9 || bits > 15) {
+                    ret.first = make_error(error::invalid_max_window_bits);
+                    return ret;
+                }
+                if (bits < m_server_max_window_bits) {
+                    m_server_max_window_bits = bits;
+                }
+            } else if (attribute.first == "client_max_window_bits") {
+                // We always inflate with a full window, nothing to negotiate
+                if (!attribute.second.empty()) {
+                    int bits = std::atoi(attribute.second.c_str());
+                    if (bits < 8 || bits > 15) {
+                        ret.first = make_error(error::invalid_max_window_bits);
+                        return ret;
+                    }
+                }
+            } else {
+                ret.first = make_error(error::invalid_attributes);
+                return ret;
+            }
+        }
+
+        ret.second = "permessage-deflate";
+        if (m_server_no_context_takeover) {
+            ret.second += "; server_no_context_takeover";
+        }
+        if (m_client_no_context_takeover) {
+            ret.second += "; client_no_context_takeover";
+        }
+        if (m_server_max_window_bits < 15) {
+            ret.second += "; server_max_window_bits=" + std::to_string(m_server_max_window_bits);
+        }
+        return ret;
+    }
+
+    websocketpp::lib::error_code init(bool is_server) {
+        using namespace websocketpp::extensions::permessage_deflate;
+        if (!is_server) {
+            return make_error(error::general);
+        }
+        int ret = deflateInit2(&m_dstate, m_settings.level, Z_DEFLATED, -1 * m_server_max_window_bits,
+                               m_settings.mem_level, Z_DEFAULT_STRATEGY);
+        if (ret != Z_OK) {
+            return make_error(error::zlib_error);
+        }
+        ret = inflateInit2(&m_istate, -15);
+        if (ret != Z_OK) {
+            deflateEnd(&m_dstate);
+            return make_error(error::zlib_error);
+        }
+
+        // compress() runs under the connection's write lock while
+        // decompress() runs from the read handler, so each needs its own
+        m_compress_buffer.reset(new unsigned char[m_compress_buffer_size]);
+        m_decompress_buffer.reset(new unsigned char[m_compress_buffer_size]);
+        m_initialized = true;
+        m_enabled = true;
+        return websocketpp::lib::error_code();
+    }
+
+    websocketpp::lib::error_code compress(std::string const& in, std::string& out) {
+        using namespace websocketpp::extensions::permessage_deflate;
+        if (!m_initialized) {
+            return make_error(error::uninitialized);
+        }
+        if (in.empty()) {
+            // An empty message compresses to a single empty stored block
+            out.push_back(0x00);
+            return websocketpp::lib::error_code();
+        }
+
+        m_dstate.avail_in = static_cast<uInt>(in.size());
+        m_dstate.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+        do {
+            m_dstate.avail_out = static_cast<uInt>(m_compress_buffer_size);
+            m_dstate.next_out = m_compress_buffer.get();
+            if (deflate(&m_dstate, Z_SYNC_FLUSH) == Z_STREAM_ERROR) {
+                return make_error(error::zlib_error);
+            }
+            size_t output = m_compress_buffer_size - m_dstate.avail_out;
+            out.append(reinterpret_cast<char*>(m_compress_buffer.get()), output);
+        } while (m_dstate.avail_out == 0);
+
+        // RFC 7692 7.2.1: drop the 0x00 0x00 0xff 0xff sync flush trailer
+        if (out.size() >= 4 && out.compare(out.size() - 4, 4, std::string("\x00\x00\xff\xff", 4)) == 0) {
+            out.resize(out.size() - 4);
+        }
+
+        if (m_server_no_context_takeover) {
+            deflateReset(&m_dstate);
+        }
+        return websocketpp::lib::error_code();
+    }
+
+    websocketpp::lib::error_code decompress(uint8_t const* buf, size_t len, std::string& out) {
+        using namespace websocketpp::extensions::permessage_deflate;
+        if (!m_initialized) {
+            return make_error(error::uninitialized);
+        }
+
+        m_istate.avail_in = static_cast<uInt>(len);
+        m_istate.next_in = const_cast<unsigned char*>(buf);
+        do {
+            m_istate.avail_out = static_cast<uInt>(m_compress_buffer_size);
+            m_istate.next_out = m_decompress_buffer.get();
+            int ret = inflate(&m_istate, Z_SYNC_FLUSH);
+            if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+                return make_error(error::zlib_error);
+            }
+            out.append(reinterpret_cast<char*>(m_decompress_buffer.get()),
+                       m_compress_buffer_size - m_istate.avail_out);
+        } while (m_istate.avail_out == 0);
+
+        return websocketpp::lib::error_code();
+    }
+
+private:
+    static websocketpp::lib::error_code make_error(error_value value) {
+        return websocketpp::extensions::permessage_deflate::error::make_error_code(value);
+    }
+
+    static int clampWindowBits(int bits) {
+        return bits < 9 ? 9 : (bits > 15 ? 15 : bits);
+    }
+
+    DeflateSettings m_settings;
+    bool m_enabled;
+    bool m_initialized;
+    bool m_server_no_context_takeover;
+    bool m_client_no_context_takeover;
+    int m_server_max_window_bits;
+    size_t m_compress_buffer_size;
+    std::unique_ptr<unsigned char[]> m_compress_buffer;
+    std::unique_ptr<unsigned char[]> m_decompress_buffer;
+    z_stream m_dstate;
+    z_stream m_istate;
+};
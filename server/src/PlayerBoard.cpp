@@ -1,119 +1,92 @@
 #include "PlayerBoard.hpp"
 #include "TileFactory.hpp"
-#include <algorithm>
-#include <stdexcept>
-#include <memory>
 
-PlayerBoard::PlayerBoard(int owner) {
-    initializeTilePiles(owner);
-}
+namespace {
+    // Levels of each pile from the top down, lowest level first
+    constexpr int COAL_PILE[] = {1, 2, 2, 3, 3, 4, 4};
+    constexpr int IRON_PILE[] = {1, 2, 3, 4};
+    constexpr int COTTON_PILE[] = {1, 1, 1, 2, 2, 3, 3, 3, 4, 4, 4};
+    constexpr int MANUFACTURER_PILE[] = {1, 2, 2, 3, 4, 5, 5, 6, 7, 8, 8};
+    constexpr int POTTERY_PILE[] = {1, 2, 3, 4, 5};
+    constexpr int BREWERY_PILE[] = {1, 1, 2, 2, 3, 3, 4};
+
+    struct Pile {
+        const int* levels;
+        int size;
+    };
 
-std::shared_ptr<Tile> PlayerBoard::peekTile(TileType type) const {
-    auto it = tilePiles.find(type);
-    if (it != tilePiles.end() && !it->second.empty()) {
-        return it->second.back();
+    template <int N>
+    constexpr Pile pile(const int (&levels)[N]) {
+        return {levels, N};
     }
-    return nullptr;
-}
 
-std::shared_ptr<Tile> PlayerBoard::takeTile(TileType type) {
-    auto it = tilePiles.find(type);
-    if (it != tilePiles.end() && !it->second.empty()) {
-        auto tile = it->second.back();
-        it->second.pop_back();
-        return tile;
+    // Indexed by TileType, Coal to Brewery
+    constexpr Pile PILES[] = {
+        pile(COAL_PILE),
+        pile(IRON_PILE),
+        pile(COTTON_PILE),
+        pile(MANUFACTURER_PILE),
+        pile(POTTERY_PILE),
+        pile(BREWERY_PILE),
+    };
+
+    constexpr bool pilesMatchCatalog() {
+        for (int type = 0; type < static_cast<int>(sizeof(PILES) / sizeof(PILES[0])); type++) {
+            // A count check rather than comparing find() with nullptr, which
+            // is not a constant expression under -fsanitize=undefined
+            int levels = TileCatalog::levelsOf(static_cast<TileType>(type)).count;
+            for (int i = 0; i < PILES[type].size; i++) {
+                if (PILES[type].levels[i] < 1 || PILES[type].levels[i] > levels) {
+                    return false;
+                }
+                if (i > 0 && PILES[type].levels[i] < PILES[type].levels[i - 1]) {
+                    return false;
+                }
+            }
+        }
+        return true;
     }
-    return nullptr;
-}
 
-bool PlayerBoard::hasTiles(TileType type) const {
-    auto it = tilePiles.find(type);
-    return (it != tilePiles.end() && !it->second.empty());
-}
+    static_assert(static_cast<int>(TileType::Brewery) == 5, "piles are indexed by TileType");
+    static_assert(pilesMatchCatalog(), "every pile entry must be a catalog level, lowest first");
 
-size_t PlayerBoard::getRemainingTileAmount(TileType type) const {
-    auto it = tilePiles.find(type);
-    if (it != tilePiles.end()) {
-        return it->second.size();
+    int pileIndex(TileType type) {
+        int index = static_cast<int>(type);
+        return index >= 0 && index <= static_cast<int>(TileType::Brewery) ? index : -1;
     }
-    return 0;
 }
 
-void PlayerBoard::initializeTilePiles(int owner) {
-    // Initialize Coal tiles
-    tilePiles[TileType::Coal] = {
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Coal, 1, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Coal, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Coal, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Coal, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Coal, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Coal, 4, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Coal, 4, owner))
-    };
-
-    // Initialize Iron tiles
-    tilePiles[TileType::Iron] = {
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Iron, 1, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Iron, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Iron, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Iron, 4, owner))
-    };
+Tile TileDescriptor::makeTile() const {
+    return TileFactory::createTile(type, level, owner);
+}
 
-    // Initialize Cotton tiles
-    tilePiles[TileType::Cotton] = {
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 1, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 1, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 1, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 4, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 4, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Cotton, 4, owner))
-    };
+PlayerBoard::PlayerBoard(int owner) : owner(owner) {}
 
-    // Initialize Manufacturer tiles
-    tilePiles[TileType::Manufacturer] = {
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 1, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 4, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 5, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 5, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 6, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 7, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 8, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Manufacturer, 8, owner))
-    };
+TileDescriptor PlayerBoard::peekTile(TileType type) const {
+    int index = pileIndex(type);
+    if (index < 0 || taken[index] >= PILES[index].size) {
+        return TileDescriptor();
+    }
+    int level = PILES[index].levels[taken[index]];
+    return TileDescriptor{type, level, owner, TileCatalog::find(type, level)};
+}
 
-    // Initialize Pottery tiles
-    tilePiles[TileType::Pottery] = {
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Pottery, 1, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Pottery, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Pottery, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Pottery, 4, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Pottery, 5, owner))
-    };
+TileDescriptor PlayerBoard::takeTile(TileType type) {
+    TileDescriptor tile = peekTile(type);
+    if (tile) {
+        taken[pileIndex(type)]++;
+    }
+    return tile;
+}
 
-    // Initialize Brewery tiles
-    tilePiles[TileType::Brewery] = {
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Brewery, 1, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Brewery, 1, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Brewery, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Brewery, 2, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Brewery, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Brewery, 3, owner)),
-        std::make_shared<Tile>(TileFactory::createTile(TileType::Brewery, 4, owner))
-    };
+bool PlayerBoard::hasTiles(TileType type) const {
+    return getRemainingTileAmount(type) > 0;
+}
 
-    // Sort each pile in descending order of level (so highest level is at the back)
-    for (auto& pile : tilePiles) {
-        std::sort(pile.second.begin(), pile.second.end(),
-                  [](const std::shared_ptr<Tile>& a, const std::shared_ptr<Tile>& b) {
-                      return a->level > b->level;
-                  });
+size_t PlayerBoard::getRemainingTileAmount(TileType type) const {
+    int index = pileIndex(type);
+    if (index < 0) {
+        return 0;
     }
-}
\ No newline at end of file
+    return PILES[index].size - taken[index];
+}
@@ -2,20 +2,33 @@
 #define PLAYERBOARD_HPP
 
 #include "Tile.hpp"
-#include <map>
-#include <vector>
-#include <memory>
+#include "TileCatalog.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/// A tile still on a player board: its catalog entry and owner. Cheap to
+/// copy; turned into a Tile only when it is placed.
+struct TileDescriptor {
+    TileType type = TileType::NullTile;
+    int level = 0;
+    int owner = -1;
+    // nullptr when the pile was empty
+    const TileStats* stats = nullptr;
+
+    explicit operator bool() const { return stats != nullptr; }
+    Tile makeTile() const;
+};
 
 class PlayerBoard {
 public:
     PlayerBoard(int owner);
-    
+
     // Get the top tile of a specific type without removing it
-    std::shared_ptr<Tile> peekTile(TileType type) const;
-    
+    TileDescriptor peekTile(TileType type) const;
+
     // Remove and return the top tile of a specific type
-    std::shared_ptr<Tile> takeTile(TileType type);
-    
+    TileDescriptor takeTile(TileType type);
+
     // Check if there are any tiles left of a specific type
     bool hasTiles(TileType type) const;
 
@@ -23,9 +36,13 @@ public:
     size_t getRemainingTileAmount(TileType type) const;
 
 private:
-    std::map<TileType, std::vector<std::shared_ptr<Tile>>> tilePiles;
-    
-    void initializeTilePiles(int owner);
+    // One pile per industry, Coal to Brewery
+    static const int PILE_COUNT = 6;
+
+    // The piles themselves are the same for every player and live in a
+    // static layout; a board only counts how many tiles were taken from each
+    int owner;
+    uint8_t taken[PILE_COUNT] = {};
 };
 
-#endif // PLAYERBOARD_HPP
\ No newline at end of file
+#endif // PLAYERBOARD_HPP
@@ -0,0 +1,78 @@
+#include "RoomManager.hpp"
+#include <cctype>
+
+const std::string RoomManager::DEFAULT_ROOM = "lobby";
+
+RoomManager::RoomManager(websocketpp::lib::asio::io_service& io_service, size_t maxRooms)
+    : m_io_service(io_service), m_max_rooms(maxRooms) {}
+
+std::shared_ptr<GameRoom> RoomManager::acquire(const std::string& roomId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_rooms.find(roomId);
+    if (it == m_rooms.end()) {
+        if (m_rooms.size() >= m_max_rooms) {
+            return nullptr;
+        }
+        it = m_rooms.emplace(roomId, std::make_shared<GameRoom>(roomId, m_io_service)).first;
+    }
+    it->second->m_members++;
+    return it->second;
+}
+
+void RoomManager::release(const std::shared_ptr<GameRoom>& room) {
+    if (!room) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--room->m_members == 0) {
+        auto it = m_rooms.find(room->id());
+        if (it != m_rooms.end() && it->second == room) {
+            m_rooms.erase(it);
+        }
+    }
+}
+
+size_t RoomManager::roomCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rooms.size();
+}
+
+std::vector<std::shared_ptr<GameRoom>> RoomManager::rooms() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::shared_ptr<GameRoom>> rooms;
+    rooms.reserve(m_rooms.size());
+    for (const auto& room : m_rooms) {
+        rooms.push_back(room.second);
+    }
+    return rooms;
+}
+
+bool RoomManager::roomIdFromResource(const std::string& resource, std::string& roomId) {
+    std::string path = resource.substr(0, resource.find('?'));
+
+    // Accept both "/<id>" and "/rooms/<id>"
+    static const std::string ROOMS_PREFIX = "/rooms/";
+    if (path.compare(0, ROOMS_PREFIX.size(), ROOMS_PREFIX) == 0) {
+        path = path.substr(ROOMS_PREFIX.size());
+    } else if (!path.empty() && path[0] == '/') {
+        path = path.substr(1);
+    }
+    while (!path.empty() && path.back() == '/') {
+        path.pop_back();
+    }
+
+    if (path.empty()) {
+        roomId = DEFAULT_ROOM;
+        return true;
+    }
+    if (path.size() > MAX_ROOM_ID_LENGTH) {
+        return false;
+    }
+    for (char c : path) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+            return false;
+        }
+    }
+    roomId = path;
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "GameRoom.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Owns every live GameRoom of the process, keyed by room id. Rooms are
+/// created on first join and dropped when their last session leaves.
+class RoomManager {
+public:
+    static const std::string DEFAULT_ROOM;
+    static const size_t MAX_ROOM_ID_LENGTH = 64;
+
+    explicit RoomManager(websocketpp::lib::asio::io_service& io_service, size_t maxRooms = 10000);
+
+    // Get or create the room and register one more member. Returns nullptr
+    // when the room does not exist yet and the room limit has been reached.
+    std::shared_ptr<GameRoom> acquire(const std::string& roomId);
+
+    // Unregister one member, removing the room once it becomes empty
+    void release(const std::shared_ptr<GameRoom>& room);
+
+    size_t roomCount() const;
+
+    // Snapshot of the live rooms, for periodic maintenance
+    std::vector<std::shared_ptr<GameRoom>> rooms() const;
+
+    // Extract the room id from a handshake resource such as "/rooms/abc?x=1"
+    // or "/abc". Returns false if the id contains unsupported characters.
+    static bool roomIdFromResource(const std::string& resource, std::string& roomId);
+
+private:
+    mutable std::mutex m_mutex;
+    websocketpp::lib::asio::io_service& m_io_service;
+    std::unordered_map<std::string, std::shared_ptr<GameRoom>> m_rooms;
+    size_t m_max_rooms;
+};
@@ -0,0 +1,208 @@
+#include "Simulator.hpp"
+#include "GameState.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    const TileType INDUSTRIES[] = {TileType::Coal, TileType::Iron, TileType::Cotton,
+                                   TileType::Manufacturer, TileType::Pottery, TileType::Brewery};
+    const GameAction::Type GUESSED_TYPES[] = {GameAction::Type::PlaceTile, GameAction::Type::PlaceLink,
+                                              GameAction::Type::TakeLoan, GameAction::Type::Develop,
+                                              GameAction::Type::Sell};
+
+    // Rounds per era by player count, two to four players
+    int roundsPerEra(int players) {
+        return players <= 2 ? 10 : players == 3 ? 9 : 8;
+    }
+
+    // Lower is preferred by the heuristic player
+    int priority(GameAction::Type type) {
+        switch (type) {
+            case GameAction::Type::Sell:
+                return 0;
+            case GameAction::Type::PlaceTile:
+                return 1;
+            case GameAction::Type::PlaceLink:
+                return 2;
+            case GameAction::Type::Develop:
+                return 3;
+            default:
+                return 4;
+        }
+    }
+
+    template <typename T, size_t N>
+    const T& pick(const T (&options)[N], std::mt19937_64& rng) {
+        return options[std::uniform_int_distribution<size_t>(0, N - 1)(rng)];
+    }
+
+    GameAction guessAction(const GameState& state, std::mt19937_64& rng) {
+        const GameBoard& board = state.m_board;
+        GameAction action;
+        action.type = pick(GUESSED_TYPES, rng);
+        action.city = std::uniform_int_distribution<CityId>(0, static_cast<CityId>(board.getCityCount()) - 1)(rng);
+        std::vector<CityId> neighbours = board.getConnections(action.city);
+        if (!neighbours.empty()) {
+            action.city2 = neighbours[std::uniform_int_distribution<size_t>(0, neighbours.size() - 1)(rng)];
+        }
+        const City* city = board.getCity(action.city);
+        int slots = city ? static_cast<int>(city->slots.size()) : 0;
+        action.slotIndex = slots > 0 ? std::uniform_int_distribution<int>(0, slots - 1)(rng) : 0;
+        action.tileType = pick(INDUSTRIES, rng);
+        action.tileType2 = std::bernoulli_distribution(0.5)(rng) ? pick(INDUSTRIES, rng) : TileType::NullTile;
+        return action;
+    }
+
+    bool chooseAction(const GameState& state, int playerId, std::mt19937_64& rng, GameAction& chosen) {
+        std::vector<GameAction> best;
+        int bestPriority = 0;
+        state.forEachLegalAction(playerId, [&](const GameAction& action) {
+            int p = priority(action.type);
+            if (best.empty() || p < bestPriority) {
+                best.clear();
+                bestPriority = p;
+            }
+            if (p == bestPriority) {
+                best.push_back(action);
+            }
+        });
+        if (best.empty()) {
+            return false;
+        }
+        chosen = best[std::uniform_int_distribution<size_t>(0, best.size() - 1)(rng)];
+        return true;
+    }
+
+    void record(SimStats& stats, const GameAction& action, bool accepted) {
+        auto& counters = accepted ? stats.accepted : stats.rejected;
+        counters[static_cast<size_t>(action.type)]++;
+    }
+
+    // One action of a turn. Returns false when the player had to pass.
+    bool takeAction(GameState& state, int playerId, const SimOptions& options, std::mt19937_64& rng, SimStats& stats) {
+        if (options.policy == SimPolicy::Heuristic) {
+            GameAction action;
+            if (!chooseAction(state, playerId, rng, action)) {
+                return false;
+            }
+            // A legal action that is rejected is a bug in the move generator
+            bool accepted = state.handleAction(playerId, action);
+            record(stats, action, accepted);
+            return accepted;
+        }
+        for (int attempt = 0; attempt < options.max_attempts; attempt++) {
+            GameAction action = guessAction(state, rng);
+            bool accepted = state.handleAction(playerId, action);
+            record(stats, action, accepted);
+            if (accepted) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+uint64_t SimStats::actions() const {
+    uint64_t total = 0;
+    for (uint64_t count : accepted) {
+        total += count;
+    }
+    return total;
+}
+
+uint64_t SimStats::rejections() const {
+    uint64_t total = 0;
+    for (uint64_t count : rejected) {
+        total += count;
+    }
+    return total;
+}
+
+double SimStats::gamesPerSecond() const {
+    return seconds > 0 ? games / seconds : 0;
+}
+
+double SimStats::actionsPerSecond() const {
+    return seconds > 0 ? actions() / seconds : 0;
+}
+
+void SimStats::merge(const SimStats& other) {
+    games += other.games;
+    passes += other.passes;
+    for (size_t i = 0; i < ACTION_TYPES; i++) {
+        accepted[i] += other.accepted[i];
+        rejected[i] += other.rejected[i];
+    }
+    failed_seeds.insert(failed_seeds.end(), other.failed_seeds.begin(), other.failed_seeds.end());
+}
+
+SimStats playGame(uint64_t seed, const SimOptions& options) {
+    SimStats stats;
+    stats.games = 1;
+    std::mt19937_64 rng(seed);
+    try {
+        GameState state;
+        std::vector<int> players;
+        for (int i = 0; i < std::max(options.players, 1); i++) {
+            players.push_back(state.addPlayer()->id);
+        }
+        int rounds = roundsPerEra(options.players);
+        for (int era = 0; era < 2; era++) {
+            if (era > 0) {
+                state.advanceEra();
+            }
+            for (int round = 0; round < rounds; round++) {
+                for (int playerId : players) {
+                    // Everyone takes one action in the first round of the game
+                    int actions = era == 0 && round == 0 ? 1 : 2;
+                    for (int i = 0; i < actions; i++) {
+                        if (!takeAction(state, playerId, options, rng, stats)) {
+                            stats.passes++;
+                        }
+                    }
+                }
+                // As the server would after each broadcast
+                state.takeDelta();
+            }
+        }
+    } catch (const std::exception&) {
+        stats.failed_seeds.push_back(seed);
+    }
+    return stats;
+}
+
+SimStats runSimulation(const SimOptions& options) {
+    size_t threads = options.threads > 0 ? options.threads : std::thread::hardware_concurrency();
+    threads = std::max<size_t>(1, std::min(threads, options.games));
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    SimStats total;
+    auto worker = [&]() {
+        SimStats local;
+        for (size_t game = next++; game < options.games; game = next++) {
+            local.merge(playGame(options.seed + game, options));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        total.merge(local);
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    std::sort(total.failed_seeds.begin(), total.failed_seeds.end());
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
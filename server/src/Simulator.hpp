@@ -0,0 +1,55 @@
+#pragma once
+
+#include "GameAction.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class SimPolicy {
+    // Guesses actions at random, so most of them are rejected by the rules
+    Random,
+    // Picks from the legal actions, preferring sales and industry over
+    // links, develops and loans
+    Heuristic,
+};
+
+struct SimOptions {
+    size_t games = 100;
+    // Zero uses one thread per core
+    size_t threads = 0;
+    // Game i is played with seed + i
+    uint64_t seed = 1;
+    int players = 4;
+    SimPolicy policy = SimPolicy::Heuristic;
+    // Guesses a random player makes before passing
+    int max_attempts = 20;
+};
+
+/// Totals over one or more simulated games
+struct SimStats {
+    static constexpr size_t ACTION_TYPES = static_cast<size_t>(GameAction::Type::Unknown) + 1;
+
+    uint64_t games = 0;
+    // Turns on which the player found nothing the rules accepted
+    uint64_t passes = 0;
+    std::array<uint64_t, ACTION_TYPES> accepted{};
+    std::array<uint64_t, ACTION_TYPES> rejected{};
+    // Games that threw, by seed
+    std::vector<uint64_t> failed_seeds;
+    // Wall time of the whole run
+    double seconds = 0;
+
+    uint64_t actions() const;
+    uint64_t rejections() const;
+    double gamesPerSecond() const;
+    double actionsPerSecond() const;
+    void merge(const SimStats& other);
+};
+
+// Play one complete game, both eras, straight against GameState. The same
+// seed and options always play the same game.
+SimStats playGame(uint64_t seed, const SimOptions& options);
+
+// Play options.games independent games spread over options.threads threads
+SimStats runSimulation(const SimOptions& options);
@@ -41,8 +41,9 @@ Tile::Builder& Tile::Builder::beerDemand(int bd) { tile.beer_demand = bd; return
 Tile Tile::Builder::build() { return tile; }
 
 // MerchantTile implementation
-MerchantTile::MerchantTile(MerchantType mt) : Tile(), merchantType(mt) {
+MerchantTile::MerchantTile(MerchantType mt) : Tile() {
     type = TileType::Merchant;
+    merchantType = mt;
 }
 
 TileType Tile::stringToTileType(const std::string& typeStr) {
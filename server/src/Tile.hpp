@@ -30,6 +30,8 @@ public:
     class Builder;
 
     TileType type = TileType::NullTile;
+    // Only set on merchant tiles
+    MerchantType merchantType = MerchantType::Empty;
     int owner = -1;
     int level = 0;
     bool flipped = false;
@@ -51,10 +53,6 @@ public:
     Tile(TileType t, int owner, int l, bool f, int i, int vp, int lp, 
          int cm, int cc, int ci, int ra, int bd);
 
-    virtual ~Tile() = default;
-    virtual std::shared_ptr<Tile> clone() const {
-        return std::make_shared<Tile>(*this);
-    }
     int consumeResources(int amount);
 
     static TileType stringToTileType(const std::string& typeStr);
@@ -66,17 +64,13 @@ public:
     static Builder create(TileType type);
 };
 
+/// Convenience constructor for merchant tiles. Adds no state, so it can be
+/// passed anywhere a Tile is expected.
 class MerchantTile : public Tile {
 public:
-    MerchantType merchantType;
-
     MerchantTile(MerchantType mt);
 
     static MerchantTile create(MerchantType mt);
-
-    std::shared_ptr<Tile> clone() const override {
-        return std::make_shared<MerchantTile>(*this);
-    }
 };
 
 class Tile::Builder {
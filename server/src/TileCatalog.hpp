@@ -0,0 +1,146 @@
+#ifndef TILECATALOG_HPP
+#define TILECATALOG_HPP
+
+#include "Tile.hpp"
+
+/// Printed stats of one industry tile level. Everything a tile needs besides
+/// its owner and the state it gathers on the board.
+struct TileStats {
+    int income;
+    int victory_points;
+    int link_points;
+    int cost_money;
+    int cost_coal;
+    int cost_iron;
+    int resource_amount;
+    int beer_demand;
+};
+
+/// The levels of one industry, level 1 first
+struct TileLevels {
+    const TileStats* stats;
+    int count;
+};
+
+/// Compile-time table of every industry tile, looked up by (type, level)
+class TileCatalog {
+public:
+    // income, VP, link points, money, coal, iron, resources, beer
+    static constexpr TileStats COAL[] = {
+        {4, 1, 2, 5, 0, 0, 2, 0},
+        {7, 2, 1, 7, 0, 0, 3, 0},
+        {6, 3, 1, 8, 0, 1, 4, 0},
+        {5, 4, 1, 10, 0, 1, 4, 0},
+    };
+
+    static constexpr TileStats IRON[] = {
+        {3, 3, 1, 5, 1, 0, 4, 0},
+        {3, 5, 1, 7, 1, 0, 4, 0},
+        {2, 7, 1, 9, 1, 0, 5, 0},
+        {1, 9, 1, 12, 1, 0, 6, 0},
+    };
+
+    static constexpr TileStats COTTON[] = {
+        {5, 5, 1, 12, 0, 0, 0, 1},
+        {4, 5, 2, 14, 1, 0, 0, 1},
+        {3, 9, 1, 16, 1, 1, 0, 1},
+        {2, 12, 1, 18, 1, 1, 0, 1},
+    };
+
+    static constexpr TileStats MANUFACTURER[] = {
+        {5, 3, 2, 8, 1, 0, 0, 1},
+        {1, 5, 1, 10, 0, 1, 0, 1},
+        {4, 4, 0, 12, 2, 0, 0, 0},
+        {8, 3, 1, 8, 0, 1, 0, 1},
+        {2, 8, 2, 16, 1, 0, 0, 1},
+        {6, 7, 1, 20, 0, 0, 0, 1},
+        {4, 9, 0, 16, 1, 1, 0, 0},
+        {1, 11, 1, 20, 0, 2, 0, 1},
+    };
+
+    static constexpr TileStats POTTERY[] = {
+        {5, 10, 1, 17, 0, 1, 0, 1},
+        {1, 1, 1, 0, 0, 1, 0, 1},
+        {5, 11, 1, 22, 2, 0, 0, 2},
+        {1, 1, 1, 0, 1, 0, 0, 1},
+        {5, 22, 1, 24, 2, 0, 0, 2},
+    };
+
+    // Canal era beer amounts
+    static constexpr TileStats BREWERY[] = {
+        {4, 4, 2, 5, 0, 1, 1, 0},
+        {5, 5, 2, 7, 0, 1, 1, 0},
+        {5, 7, 2, 9, 0, 1, 1, 0},
+        {5, 9, 2, 9, 0, 1, 1, 0},
+    };
+
+    static constexpr TileLevels levelsOf(TileType type) {
+        switch (type) {
+            case TileType::Coal:
+                return levels(COAL);
+            case TileType::Iron:
+                return levels(IRON);
+            case TileType::Cotton:
+                return levels(COTTON);
+            case TileType::Manufacturer:
+                return levels(MANUFACTURER);
+            case TileType::Pottery:
+                return levels(POTTERY);
+            case TileType::Brewery:
+                return levels(BREWERY);
+            default:
+                return {nullptr, 0};
+        }
+    }
+
+    // nullptr for a type without levels or a level out of range
+    static constexpr const TileStats* find(TileType type, int level) {
+        TileLevels entry = levelsOf(type);
+        return level >= 1 && level <= entry.count ? &entry.stats[level - 1] : nullptr;
+    }
+
+    static constexpr bool producesResources(TileType type) {
+        return type == TileType::Coal || type == TileType::Iron || type == TileType::Brewery;
+    }
+
+    // Checked by static_assert below, so a bad edit fails the build
+    static constexpr bool isValid(TileType type) {
+        TileLevels entry = levelsOf(type);
+        for (int i = 0; i < entry.count; i++) {
+            const TileStats& s = entry.stats[i];
+            if (s.income < 0 || s.victory_points < 0 || s.link_points < 0 || s.cost_money < 0 ||
+                s.cost_coal < 0 || s.cost_iron < 0 || s.resource_amount < 0 || s.beer_demand < 0) {
+                return false;
+            }
+            // Resource tiles are consumed, the others are sold for beer
+            if (producesResources(type) ? (s.resource_amount == 0 || s.beer_demand != 0)
+                                        : s.resource_amount != 0) {
+                return false;
+            }
+            if (s.beer_demand > 2 || s.cost_coal > 2 || s.cost_iron > 2) {
+                return false;
+            }
+        }
+        return entry.count > 0;
+    }
+
+private:
+    template <int N>
+    static constexpr TileLevels levels(const TileStats (&stats)[N]) {
+        return {stats, N};
+    }
+};
+
+static_assert(TileCatalog::levelsOf(TileType::Coal).count == 4, "coal has 4 levels");
+static_assert(TileCatalog::levelsOf(TileType::Iron).count == 4, "iron has 4 levels");
+static_assert(TileCatalog::levelsOf(TileType::Cotton).count == 4, "cotton has 4 levels");
+static_assert(TileCatalog::levelsOf(TileType::Manufacturer).count == 8, "manufacturers have 8 levels");
+static_assert(TileCatalog::levelsOf(TileType::Pottery).count == 5, "pottery has 5 levels");
+static_assert(TileCatalog::levelsOf(TileType::Brewery).count == 4, "breweries have 4 levels");
+static_assert(TileCatalog::isValid(TileType::Coal) && TileCatalog::isValid(TileType::Iron) &&
+                  TileCatalog::isValid(TileType::Cotton) && TileCatalog::isValid(TileType::Manufacturer) &&
+                  TileCatalog::isValid(TileType::Pottery) && TileCatalog::isValid(TileType::Brewery),
+              "tile catalog entry out of range");
+static_assert(TileCatalog::find(TileType::Merchant, 1) == nullptr, "merchant tiles have no levels");
+
+#endif // TILECATALOG_HPP
@@ -0,0 +1,32 @@
+#include "TokenBucket.hpp"
+#include <algorithm>
+
+TokenBucket::TokenBucket(double rate, double burst, clock::time_point now)
+    : m_rate(rate), m_burst(burst), m_tokens(burst), m_last(now) {}
+
+void TokenBucket::refill(clock::time_point now) {
+    if (now <= m_last) {
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(now - m_last).count();
+    m_tokens = std::min(m_burst, m_tokens + elapsed * m_rate);
+    m_last = now;
+}
+
+bool TokenBucket::tryConsume(double tokens, clock::time_point now) {
+    if (m_rate <= 0) {
+        return true;
+    }
+    refill(now);
+    tokens = std::min(tokens, m_burst);
+    if (m_tokens < tokens) {
+        return false;
+    }
+    m_tokens -= tokens;
+    return true;
+}
+
+double TokenBucket::available(clock::time_point now) {
+    refill(now);
+    return m_tokens;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+
+/// Classic token bucket: refills at `rate` tokens per second up to `burst`
+/// tokens. A rate of zero or less disables limiting.
+class TokenBucket {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    TokenBucket() : TokenBucket(0, 0) {}
+    TokenBucket(double rate, double burst, clock::time_point now = clock::now());
+
+    // Take `tokens` if available. Requests larger than the burst size are
+    // charged as a full bucket so they can still pass when it is full.
+    bool tryConsume(double tokens, clock::time_point now = clock::now());
+
+    double available(clock::time_point now = clock::now());
+
+private:
+    void refill(clock::time_point now);
+
+    double m_rate;
+    double m_burst;
+    double m_tokens;
+    clock::time_point m_last;
+};
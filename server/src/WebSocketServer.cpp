@@ -1,19 +1,34 @@
 #include "WebSocketServer.hpp"
-#include <iostream>
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include <stdexcept>
 
 using websocketpp::lib::placeholders::_1;
 using websocketpp::lib::placeholders::_2;
 using websocketpp::lib::bind;
 
-WebSocketServer::WebSocketServer() {
-    m_server.init_asio();
+WebSocketServer::WebSocketServer(const ServerOptions& options)
+    : m_options(options),
+      m_rooms(m_io_service),
+      m_backpressure(options.max_buffered_bytes, options.slow_consumer_timeout),
+      m_msg_manager(std::make_shared<msg_manager>()),
+      m_frame_processor(new frame_processor(false, true, m_msg_manager, m_rng)) {
+    // Copied by every connection's extension instance when it is created
+    if (!BrassServerConfig::permessage_deflate_config::settings().publish(m_options.deflate)) {
+        throw std::invalid_argument("permessage-deflate settings differ from another server in this process");
+    }
+
+    m_server.init_asio(&m_io_service);
 
     m_server.set_reuse_addr(true);
+    m_server.set_max_message_size(m_options.max_message_size);
 
+    m_server.set_validate_handler(bind(&WebSocketServer::on_validate, this, ::_1));
     m_server.set_open_handler(bind(&WebSocketServer::on_open, this, ::_1));
     m_server.set_close_handler(bind(&WebSocketServer::on_close, this, ::_1));
     m_server.set_message_handler(bind(&WebSocketServer::on_message, this, ::_1, ::_2));
     m_server.set_fail_handler(bind(&WebSocketServer::on_fail, this, ::_1));
+    m_server.set_http_handler(bind(&WebSocketServer::on_http, this, ::_1));
 
     m_server.clear_access_channels(websocketpp::log::alevel::all);
     m_server.set_access_channels(websocketpp::log::alevel::connect);
@@ -24,108 +39,444 @@ WebSocketServer::WebSocketServer() {
     m_server.set_pong_timeout_handler(bind(&WebSocketServer::on_pong_timeout, this, ::_1, ::_2));
 }
 
-void WebSocketServer::run(uint16_t port) {
+void WebSocketServer::run(uint16_t port, size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
     m_server.listen(port);
     m_server.start_accept();
-    std::cout << "Server listening on port " << port << std::endl;
-    m_server.run();
+    schedule_backpressure_check();
+    LOG_INFO("ws", "Server listening on port " << port << " with " << thread_count << " io threads");
+
+    // The calling thread is one of the pool threads
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < thread_count; ++i) {
+        pool.emplace_back([this]() { run_io(); });
+    }
+    run_io();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+void WebSocketServer::run_io() {
+    try {
+        m_server.run();
+    } catch (const std::exception& e) {
+        LOG_ERROR("ws", "io thread terminated: " << e.what());
+    }
+}
+
+WebSocketServer::server::connection_ptr WebSocketServer::get_connection(websocketpp::connection_hdl hdl) {
+    websocketpp::lib::error_code ec;
+    server::connection_ptr con = m_server.get_con_from_hdl(hdl, ec);
+    if (ec) {
+        return server::connection_ptr();
+    }
+    return con;
 }
 
 void WebSocketServer::stop() {
     m_server.stop_listening();
-    for (auto& conn : m_connections) {
+    std::vector<websocketpp::connection_hdl> handles;
+    {
+        std::lock_guard<std::mutex> lock(m_connections_mutex);
+        handles.assign(m_connections.begin(), m_connections.end());
+    }
+    for (auto& hdl : handles) {
         try {
-            m_server.close(conn.first, websocketpp::close::status::going_away, "Server shutdown");
+            m_server.close(hdl, websocketpp::close::status::going_away, "Server shutdown");
         } catch (const websocketpp::exception& e) {
-            std::cerr << "Error closing connection: " << e.what() << std::endl;
+            LOG_WARN("ws", "Error closing connection: " << e.what());
         }
     }
     m_server.stop();
 }
 
+Session* WebSocketServer::admit_message(websocketpp::connection_hdl hdl, size_t size) {
+    server::connection_ptr con = get_connection(hdl);
+    if (!con || !con->session) {
+        LOG_WARN("ws", "Unknown connection sent a message");
+        return nullptr;
+    }
+    Session& session = *con->session;
+    auto now = TokenBucket::clock::now();
+    // Charge the byte budget only for messages that pass the count limit
+    if (size > 0 && session.messages.tryConsume(1, now) && session.bytes.tryConsume(static_cast<double>(size), now)) {
+        session.violations = 0;
+        Metrics::instance().messageIn(size);
+        return &session;
+    }
+
+    Metrics::instance().messageDropped();
+    LOG_DEBUG("ws", "Dropped message of " << size << " bytes over the rate limit");
+    if (++session.violations == m_options.max_rate_violations) {
+        LOG_WARN("ws", "Closing connection after " << m_options.max_rate_violations << " messages over the rate limit");
+        try {
+            m_server.close(hdl, websocketpp::close::status::policy_violation, "Rate limit exceeded");
+        } catch (const websocketpp::exception& e) {
+            LOG_WARN("ws", "Error closing connection: " << e.what());
+        }
+    }
+    return nullptr;
+}
+
+bool WebSocketServer::on_validate(websocketpp::connection_hdl hdl) {
+    server::connection_ptr con = m_server.get_con_from_hdl(hdl);
+    std::string room_id;
+    if (!RoomManager::roomIdFromResource(con->get_resource(), room_id)) {
+        LOG_WARN("ws", "Rejected connection with invalid room: " << con->get_resource());
+        con->set_status(websocketpp::http::status_code::bad_request);
+        return false;
+    }
+
+    std::string subprotocol;
+    if (WireProtocol::negotiate(con->get_requested_subprotocols(), subprotocol)) {
+        con->select_subprotocol(subprotocol);
+    }
+    return true;
+}
+
 void WebSocketServer::on_open(websocketpp::connection_hdl hdl) {
     server::connection_ptr con = m_server.get_con_from_hdl(hdl);
-    std::cout << "New connection from " << con->get_remote_endpoint() << std::endl;
+    LOG_INFO("ws", "New connection from " << con->get_remote_endpoint());
+
+    std::string room_id;
+    RoomManager::roomIdFromResource(con->get_resource(), room_id);
+    auto room = m_rooms.acquire(room_id);
+    if (!room) {
+        LOG_WARN("ws", "Room limit reached, refusing room " << room_id);
+        try {
+            m_server.close(hdl, websocketpp::close::status::try_again_later, "Room limit reached");
+        } catch (const websocketpp::exception& e) {
+            LOG_WARN("ws", "Error closing connection: " << e.what());
+        }
+        return;
+    }
+
+    WireFormat format = WireProtocol::fromSubprotocol(con->get_subprotocol());
+    bool deflate = con->get_response_header("Sec-WebSocket-Extensions").find("permessage-deflate") != std::string::npos;
+    LOG_DEBUG("ws", "Connection format " << con->get_subprotocol() << ", permessage-deflate " << (deflate ? "on" : "off"));
+    auto now = TokenBucket::clock::now();
+    con->session = std::make_shared<Session>(Session{room, format, deflate,
+                                                     TokenBucket(m_options.messages_per_second, m_options.message_burst, now),
+                                                     TokenBucket(m_options.bytes_per_second, m_options.byte_burst, now), 0});
+    {
+        std::lock_guard<std::mutex> lock(m_connections_mutex);
+        m_connections.insert(hdl);
+    }
+    Metrics::instance().connectionOpened();
 
-    auto new_player = m_game_state.addPlayer();
-    m_connections[hdl] = new_player;
-    std::cout << "New player connected. ID: " << new_player->id << std::endl;
+    room->post([this, room, hdl, format, deflate]() {
+        auto new_player = room->state().addPlayer();
+        LOG_INFO("ws", "New player connected to room " << room->id() << ". ID: " << new_player->id);
 
-    broadcast_game_state();
+        // Existing members get the join as a delta, the newcomer a full snapshot
+        broadcast_changes(*room);
+        GameRoom::Member& member = room->connections()[hdl] = GameRoom::Member{new_player, format, deflate};
+        send_snapshot(*room, hdl, member);
+    });
 }
 
 void WebSocketServer::on_close(websocketpp::connection_hdl hdl) {
-    auto it = m_connections.find(hdl);
-    if (it != m_connections.end()) {
-        std::cout << "Player " << it->second->id << " disconnected" << std::endl;
-        m_game_state.removePlayer(it->second->id);
-        m_connections.erase(it);
-        broadcast_game_state();
-    } else {
-        std::cout << "Unknown connection closed" << std::endl;
+    server::connection_ptr con = get_connection(hdl);
+    if (!con || !con->session) {
+        LOG_WARN("ws", "Unknown connection closed");
+        return;
+    }
+    std::shared_ptr<Session> session = std::move(con->session);
+    {
+        std::lock_guard<std::mutex> lock(m_connections_mutex);
+        m_connections.erase(hdl);
     }
+    Metrics::instance().connectionClosed();
+
+    auto room = session->room;
+    room->post([this, room, hdl]() {
+        auto member = room->connections().find(hdl);
+        if (member == room->connections().end()) {
+            return;
+        }
+        LOG_INFO("ws", "Player " << member->second.player->id << " disconnected from room " << room->id());
+        room->state().removePlayer(member->second.player->id);
+        room->connections().erase(member);
+        broadcast_changes(*room);
+    });
+    m_rooms.release(room);
 }
 
 void WebSocketServer::on_fail(websocketpp::connection_hdl hdl) {
     server::connection_ptr con = m_server.get_con_from_hdl(hdl);
-    std::cout << "Connection failed. Error: " << con->get_ec().message() << std::endl;
+    LOG_WARN("ws", "Connection failed. Error: " << con->get_ec().message());
 }
 
 void WebSocketServer::on_message(websocketpp::connection_hdl hdl, server::message_ptr msg) {
-    std::cout << "Received raw message: " << msg->get_payload() << std::endl;
-    
+    // Budget check first, a flooding client never reaches the decoder or the
+    // room strand
+    Session* session = admit_message(hdl, msg->get_payload().size());
+    if (!session) {
+        return;
+    }
+    LOG_TRACE("ws", "Received raw message: " << msg->get_payload());
+
     try {
-        auto j = nlohmann::json::parse(msg->get_payload());
-        std::cout << "Parsed JSON: " << j.dump(4) << std::endl;
-        
-        GameAction action = parseGameAction(j);
-        auto it = m_connections.find(hdl);
-        if (it != m_connections.end()) {
-            int playerId = it->second->id;
-            if (m_game_state.handleAction(playerId, action)) {
-                broadcast_game_state();
-            } else {
-                std::cerr << "Failed to handle action" << std::endl;
+        // Decoding runs on whichever io thread received the frame, only the
+        // game logic is serialized on the room strand.
+        // Text frames are always JSON so browsers and debugging tools keep working
+        WireFormat format = WireFormat::Json;
+        if (msg->get_opcode() == websocketpp::frame::opcode::binary) {
+            format = WireProtocol::isBinary(session->format) ? session->format : WireFormat::Cbor;
+        }
+        nlohmann::json j;
+        GameAction action;
+        bool resync = false;
+        bool legal_moves = false;
+        {
+            ScopedTimer timer(Metrics::instance().parseLatency());
+            j = WireProtocol::decode(msg->get_payload(), format);
+            std::string request = j.value("action", "");
+            resync = request == "resync";
+            legal_moves = request == "legalMoves";
+            if (!resync && !legal_moves) {
+                action = parseGameAction(j, *session->room);
             }
-        } else {
-            std::cerr << "Unknown connection sent a message" << std::endl;
         }
+        LOG_TRACE("ws", "Parsed JSON: " << j.dump(4));
+
+        auto room = session->room;
+        if (resync || legal_moves) {
+            room->post([this, room, hdl, resync]() { send_reply(*room, hdl, resync); });
+            return;
+        }
+
+        room->post([this, room, hdl, action]() {
+            auto member = room->connections().find(hdl);
+            if (member == room->connections().end()) {
+                return;
+            }
+            bool accepted;
+            {
+                ScopedTimer timer(Metrics::instance().actionLatency());
+                accepted = room->state().handleAction(member->second.player->id, action);
+            }
+            Metrics::instance().actionHandled(action.type, accepted);
+            if (!accepted) {
+                LOG_DEBUG("ws", "Failed to handle action");
+            }
+            broadcast_changes(*room);
+        });
     } catch (const nlohmann::json::exception& e) {
-        std::cerr << "JSON parsing error: " << e.what() << std::endl;
-        std::cerr << "Failed to parse: " << msg->get_payload() << std::endl;
+        LOG_WARN("ws", "JSON parsing error: " << e.what());
+        LOG_DEBUG("ws", "Failed to parse: " << msg->get_payload());
     } catch (const std::exception& e) {
-        std::cerr << "Error processing message: " << e.what() << std::endl;
+        LOG_ERROR("ws", "Error processing message: " << e.what());
     }
 }
 
-GameAction WebSocketServer::parseGameAction(const nlohmann::json& j) {
+void WebSocketServer::on_http(websocketpp::connection_hdl hdl) {
+    server::connection_ptr con = m_server.get_con_from_hdl(hdl);
+    std::string path = con->get_resource().substr(0, con->get_resource().find('?'));
+    if (path != "/metrics") {
+        con->set_status(websocketpp::http::status_code::not_found);
+        return;
+    }
+
+    Metrics& metrics = Metrics::instance();
+    metrics.setRoomCount(m_rooms.roomCount());
+    con->set_status(websocketpp::http::status_code::ok);
+    con->replace_header("Content-Type", "text/plain; version=0.0.4");
+    con->set_body(metrics.prometheus());
+}
+
+GameAction WebSocketServer::parseGameAction(const nlohmann::json& j, const GameRoom& room) {
      GameAction action;
      if (j.contains("action")) {
          std::string actionStr = j["action"];
          if (actionStr == "placeTile") {
              action.type = GameAction::Type::PlaceTile;
              if (j.contains("cityName") && j.contains("tileType") && j.contains("slotIndex")) {
-                 action.cityName = j["cityName"];
+                 action.city = room.cityId(j["cityName"].get<std::string>());
                  action.tileType = j["tileType"];
                  action.slotIndex = j["slotIndex"];
              } else {
-                 std::cerr << "Missing required fields for placeTile action" << std::endl;
+                 LOG_DEBUG("ws", "Missing required fields for placeTile action");
              }
+         } else if (actionStr == "placeLink") {
+             action.type = GameAction::Type::PlaceLink;
+             if (j.contains("cityName") && j.contains("cityName2")) {
+                 action.city = room.cityId(j["cityName"].get<std::string>());
+                 action.city2 = room.cityId(j["cityName2"].get<std::string>());
+             } else {
+                 LOG_DEBUG("ws", "Missing required fields for placeLink action");
+             }
+         } else if (actionStr == "sell") {
+             action.type = GameAction::Type::Sell;
+             if (j.contains("cityName") && j.contains("slotIndex")) {
+                 action.city = room.cityId(j["cityName"].get<std::string>());
+                 action.slotIndex = j["slotIndex"];
+             } else {
+                 LOG_DEBUG("ws", "Missing required fields for sell action");
+             }
+         } else if (actionStr == "develop") {
+             action.type = GameAction::Type::Develop;
+             if (j.contains("tileType")) {
+                 action.tileType = j["tileType"];
+                 action.tileType2 = j.value("tileType2", TileType::NullTile);
+             } else {
+                 LOG_DEBUG("ws", "Missing required fields for develop action");
+             }
+         } else if (actionStr == "takeLoan") {
+             action.type = GameAction::Type::TakeLoan;
          }
      }
      return action;
 }
 
-void WebSocketServer::broadcast_game_state() {
-    nlohmann::json game_state = m_game_state.getState();
-    std::string payload = game_state.dump();
-    std::cout << "Broadcasting game state: " << payload << std::endl;
-    
-    for (auto it : m_connections) {
-        try {
-            m_server.send(it.first, payload, websocketpp::frame::opcode::text);
-        } catch (const websocketpp::exception& e) {
-            std::cerr << "Error broadcasting game state: " << e.what() << std::endl;
+WebSocketServer::Outgoing WebSocketServer::make_outgoing(const std::string& payload, WireFormat format) {
+    websocketpp::frame::opcode::value op = WireProtocol::isBinary(format) ? websocketpp::frame::opcode::binary
+                                                                         : websocketpp::frame::opcode::text;
+    Outgoing outgoing;
+    outgoing.message = m_msg_manager->get_message(op, payload.size());
+    outgoing.message->set_payload(payload);
+    // Small frames are not worth the deflate overhead
+    outgoing.message->set_compressed(payload.size() >= m_options.compression_threshold);
+    return outgoing;
+}
+
+void WebSocketServer::send_outgoing(const server::connection_ptr& con, bool deflate, Outgoing& outgoing) {
+    websocketpp::lib::error_code ec;
+    // Deflate connections and legacy hixie-76 clients frame the message
+    // themselves, everyone else shares one pre-framed buffer
+    if ((deflate && outgoing.message->get_compressed()) || con->get_version() < 7) {
+        ec = con->send(outgoing.message);
+    } else {
+        if (!outgoing.frame) {
+            outgoing.frame = m_msg_manager->get_message();
+            ec = m_frame_processor->prepare_data_frame(outgoing.message, outgoing.frame);
+            if (ec) {
+                outgoing.frame.reset();
+                LOG_ERROR("ws", "Error preparing frame: " << ec.message());
+                return;
+            }
+        }
+        ec = con->send(outgoing.frame);
+    }
+    if (ec) {
+        LOG_WARN("ws", "Error sending frame: " << ec.message());
+        return;
+    }
+    Metrics::instance().messageOut(outgoing.message->get_payload().size());
+}
+
+void WebSocketServer::send_snapshot(GameRoom& room, websocketpp::connection_hdl hdl, const GameRoom::Member& member) {
+    server::connection_ptr con = get_connection(hdl);
+    if (!con) {
+        return;
+    }
+    nlohmann::json state = room.state().getState();
+    LOG_TRACE("ws", "Sending game state snapshot: " << state.dump());
+
+    Outgoing outgoing = make_outgoing(WireProtocol::encode(state, member.format), member.format);
+    send_outgoing(con, member.deflate, outgoing);
+}
+
+void WebSocketServer::send_reply(GameRoom& room, websocketpp::connection_hdl hdl, bool resync) {
+    auto it = room.connections().find(hdl);
+    server::connection_ptr con = get_connection(hdl);
+    if (it == room.connections().end() || !con) {
+        return;
+    }
+    GameRoom::Member& member = it->second;
+    // A stale connection already has a snapshot coming once it drains
+    if (member.outbound.stale) {
+        return;
+    }
+    nlohmann::json reply = resync ? room.state().getState() : room.state().getLegalMoves(member.player->id);
+    LOG_TRACE("ws", "Sending " << (resync ? "snapshot" : "legal moves") << " on request: " << reply.dump());
+
+    // Replies share the outbound cap with broadcasts, so a client that keeps
+    // asking without reading goes stale and is resynced or disconnected
+    Outgoing outgoing = make_outgoing(WireProtocol::encode(reply, member.format), member.format);
+    size_t size = outgoing.message->get_payload().size();
+    if (!m_backpressure.admit(member.outbound, con->get_buffered_amount(), size, Backpressure::clock::now())) {
+        LOG_DEBUG("ws", "Player " << member.player->id << " is backed up (" << con->get_buffered_amount()
+                                  << " bytes queued), dropping reply");
+        return;
+    }
+    send_outgoing(con, member.deflate, outgoing);
+}
+
+void WebSocketServer::broadcast_changes(GameRoom& room) {
+    if (!room.state().hasPendingChanges()) {
+        return;
+    }
+    ScopedTimer timer(Metrics::instance().broadcastLatency());
+    nlohmann::json delta = room.state().takeDelta();
+    LOG_TRACE("ws", "Broadcasting game state delta: " << delta.dump());
+
+    // Encode once per wire format and frame at most once, every connection
+    // using that format queues the same buffer
+    std::map<WireFormat, Outgoing> messages;
+    auto now = Backpressure::clock::now();
+    for (auto& it : room.connections()) {
+        server::connection_ptr con = get_connection(it.first);
+        if (!con) {
+            continue;
+        }
+        GameRoom::Member& member = it.second;
+        auto outgoing = messages.find(member.format);
+        if (outgoing == messages.end()) {
+            outgoing = messages.emplace(member.format, make_outgoing(WireProtocol::encode(delta, member.format), member.format)).first;
+        }
+
+        // A backed up connection skips deltas and gets one fresh snapshot
+        // when it drains, so at most one stale update sits in its buffer
+        size_t size = outgoing->second.message->get_payload().size();
+        if (!m_backpressure.admit(member.outbound, con->get_buffered_amount(), size, now)) {
+            LOG_DEBUG("ws", "Player " << member.player->id << " is backed up (" << con->get_buffered_amount()
+                                      << " bytes queued), skipping delta " << delta["seq"]);
+            continue;
+        }
+        send_outgoing(con, member.deflate, outgoing->second);
+    }
+}
+
+void WebSocketServer::schedule_backpressure_check() {
+    m_server.set_timer(m_options.backpressure_interval.count(), [this](const websocketpp::lib::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        for (auto& room : m_rooms.rooms()) {
+            room->post([this, room]() { check_backpressure(*room); });
+        }
+        schedule_backpressure_check();
+    });
+}
+
+void WebSocketServer::check_backpressure(GameRoom& room) {
+    auto now = Backpressure::clock::now();
+    for (auto& it : room.connections()) {
+        server::connection_ptr con = get_connection(it.first);
+        if (!con) {
+            continue;
+        }
+        GameRoom::Member& member = it.second;
+        switch (m_backpressure.poll(member.outbound, con->get_buffered_amount(), now)) {
+        case Backpressure::Action::Resync:
+            LOG_DEBUG("ws", "Player " << member.player->id << " caught up, sending snapshot");
+            send_snapshot(room, it.first, member);
+            break;
+        case Backpressure::Action::Disconnect:
+            LOG_WARN("ws", "Player " << member.player->id << " stayed over the outbound limit with "
+                                     << con->get_buffered_amount() << " bytes queued, disconnecting");
+            try {
+                m_server.close(it.first, websocketpp::close::status::policy_violation, "Slow consumer");
+            } catch (const websocketpp::exception& e) {
+                LOG_WARN("ws", "Error closing connection: " << e.what());
+            }
+            break;
+        case Backpressure::Action::None:
+            break;
         }
     }
 }
@@ -135,16 +486,16 @@ bool WebSocketServer::on_ping(websocketpp::connection_hdl hdl, std::string) {
         m_server.pong(hdl, "");
         return true;
     } catch (const websocketpp::exception& e) {
-        std::cerr << "Error sending pong: " << e.what() << std::endl;
+        LOG_WARN("ws", "Error sending pong: " << e.what());
         return false;
     }
 }
 
 void WebSocketServer::on_pong_timeout(websocketpp::connection_hdl hdl, std::string) {
-    std::cout << "Pong timeout. Closing connection." << std::endl;
+    LOG_INFO("ws", "Pong timeout. Closing connection.");
     try {
         m_server.close(hdl, websocketpp::close::status::policy_violation, "Pong timeout");
     } catch (const websocketpp::exception& e) {
-        std::cerr << "Error closing connection: " << e.what() << std::endl;
+        LOG_WARN("ws", "Error closing connection: " << e.what());
     }
 }
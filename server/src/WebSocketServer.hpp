@@ -2,30 +2,137 @@
 
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
+#include <websocketpp/processors/hybi13.hpp>
+#include "Backpressure.hpp"
 #include "GameState.hpp"
+#include "PerMessageDeflate.hpp"
+#include "RoomManager.hpp"
+#include "TokenBucket.hpp"
+#include <chrono>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+/// What the server keeps per connection, set up on open
+struct Session {
+    std::shared_ptr<GameRoom> room;
+    WireFormat format;
+    bool deflate;
+    // Inbound budget
+    TokenBucket messages;
+    TokenBucket bytes;
+    unsigned violations;
+};
+
+/// asio transport with our configurable permessage-deflate extension
+struct BrassServerConfig : public websocketpp::config::asio {
+    typedef BrassServerConfig type;
+
+    // Every connection object carries its own session, so the message path
+    // reaches it through the handle without a server-wide lock. websocketpp
+    // runs a connection's handlers on that connection's strand, one at a time.
+    struct connection_base {
+        std::shared_ptr<Session> session;
+    };
+
+    struct permessage_deflate_config {
+        // Published by the first WebSocketServer; websocketpp offers no
+        // per-endpoint hook, so every server in a process shares it
+        static DeflateSettingsSlot& settings() {
+            static DeflateSettingsSlot slot;
+            return slot;
+        }
+    };
+    typedef PerMessageDeflate<permessage_deflate_config> permessage_deflate_type;
+};
+
+struct ServerOptions {
+    // permessage-deflate parameters offered to clients
+    DeflateSettings deflate;
+    // Payloads smaller than this are sent uncompressed even on deflate connections
+    size_t compression_threshold = 256;
+    // Bytes a connection may have queued before state updates are dropped
+    // in favour of a snapshot once it catches up
+    size_t max_buffered_bytes = 4 * 1024 * 1024;
+    // How long a connection may stay over the limit before it is closed
+    std::chrono::milliseconds slow_consumer_timeout{15000};
+    std::chrono::milliseconds backpressure_interval{250};
+
+    // Larger inbound messages close the connection (1009 message too big)
+    size_t max_message_size = 16 * 1024;
+    // Per-connection inbound budget, zero disables a limit
+    double messages_per_second = 20;
+    double message_burst = 40;
+    double bytes_per_second = 64 * 1024;
+    double byte_burst = 128 * 1024;
+    // Messages dropped in a row before the connection is closed
+    unsigned max_rate_violations = 100;
+};
 
 class WebSocketServer {
 public:
-    WebSocketServer();
-    void run(uint16_t port);
+    explicit WebSocketServer(const ServerOptions& options = ServerOptions());
+    // Run the io_context on thread_count threads, blocking until stop()
+    void run(uint16_t port, size_t thread_count = 1);
     void stop();
 
 private:
-    typedef websocketpp::server<websocketpp::config::asio> server;
-    typedef std::map<websocketpp::connection_hdl, std::shared_ptr<Player>, std::owner_less<websocketpp::connection_hdl>> con_list;
+    typedef websocketpp::server<BrassServerConfig> server;
+    typedef BrassServerConfig::con_msg_manager_type msg_manager;
+    typedef websocketpp::processor::hybi13<BrassServerConfig> frame_processor;
 
+    // One encoded payload shared by every recipient. Connections that
+    // negotiated permessage-deflate compress the message with their own
+    // context, the others share a single pre-framed copy.
+    struct Outgoing {
+        server::message_ptr message;
+        server::message_ptr frame;
+    };
+    typedef std::set<websocketpp::connection_hdl, std::owner_less<websocketpp::connection_hdl>> connection_list;
+
+    ServerOptions m_options;
+    websocketpp::lib::asio::io_service m_io_service;
     server m_server;
-    con_list m_connections;
-    GameState m_game_state;
+    // Open connections, for shutdown. Only open and close take the lock.
+    std::mutex m_connections_mutex;
+    connection_list m_connections;
+    RoomManager m_rooms;
+    Backpressure m_backpressure;
+
+    // Frames outgoing messages once so broadcasts can share one buffer.
+    // Server frames are unmasked and this processor never negotiates
+    // compression, so the output is valid for every hybi13 connection and
+    // preparing is safe from any thread.
+    BrassServerConfig::rng_type m_rng;
+    std::shared_ptr<msg_manager> m_msg_manager;
+    std::unique_ptr<frame_processor> m_frame_processor;
 
+    void run_io();
+    server::connection_ptr get_connection(websocketpp::connection_hdl hdl);
+    // Charge one inbound message against the connection's budget, closing
+    // it after too many rejections. Returns the session when admitted.
+    Session* admit_message(websocketpp::connection_hdl hdl, size_t size);
+    bool on_validate(websocketpp::connection_hdl hdl);
     void on_open(websocketpp::connection_hdl hdl);
     void on_close(websocketpp::connection_hdl hdl);
     void on_message(websocketpp::connection_hdl hdl, server::message_ptr msg);
+    void on_http(websocketpp::connection_hdl hdl);
     void on_fail(websocketpp::connection_hdl hdl);
-    GameAction parseGameAction(const nlohmann::json& j);
-    void broadcast_game_state();
+    // City names are translated to ids here, at the JSON boundary
+    GameAction parseGameAction(const nlohmann::json& j, const GameRoom& room);
+    Outgoing make_outgoing(const std::string& payload, WireFormat format);
+    void send_outgoing(const server::connection_ptr& con, bool deflate, Outgoing& outgoing);
+    // Unconditional, for joins and backpressure resyncs
+    void send_snapshot(GameRoom& room, websocketpp::connection_hdl hdl, const GameRoom::Member& member);
+    // Reply to a "resync" request with a snapshot or to "legalMoves" with the
+    // actions the sender may take, subject to the outbound limit
+    void send_reply(GameRoom& room, websocketpp::connection_hdl hdl, bool resync);
+    void broadcast_changes(GameRoom& room);
+    void schedule_backpressure_check();
+    void check_backpressure(GameRoom& room);
     bool on_ping(websocketpp::connection_hdl hdl, std::string);
     void on_pong_timeout(websocketpp::connection_hdl hdl, std::string);
 };
\ No newline at end of file
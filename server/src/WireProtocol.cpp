@@ -0,0 +1,50 @@
+#include "WireProtocol.hpp"
+
+const char* const WireProtocol::JSON_SUBPROTOCOL = "brass.json";
+const char* const WireProtocol::CBOR_SUBPROTOCOL = "brass.cbor";
+const char* const WireProtocol::MSGPACK_SUBPROTOCOL = "brass.msgpack";
+
+bool WireProtocol::negotiate(const std::vector<std::string>& requested, std::string& selected) {
+    for (const auto& subprotocol : requested) {
+        if (subprotocol == JSON_SUBPROTOCOL || subprotocol == CBOR_SUBPROTOCOL || subprotocol == MSGPACK_SUBPROTOCOL) {
+            selected = subprotocol;
+            return true;
+        }
+    }
+    return false;
+}
+
+WireFormat WireProtocol::fromSubprotocol(const std::string& subprotocol) {
+    if (subprotocol == CBOR_SUBPROTOCOL) return WireFormat::Cbor;
+    if (subprotocol == MSGPACK_SUBPROTOCOL) return WireFormat::MessagePack;
+    return WireFormat::Json;
+}
+
+std::string WireProtocol::encode(const nlohmann::json& message, WireFormat format) {
+    std::string out;
+    switch (format) {
+        case WireFormat::Cbor:
+            nlohmann::json::to_cbor(message, out);
+            break;
+        case WireFormat::MessagePack:
+            nlohmann::json::to_msgpack(message, out);
+            break;
+        case WireFormat::Json:
+        default:
+            out = message.dump();
+            break;
+    }
+    return out;
+}
+
+nlohmann::json WireProtocol::decode(const std::string& payload, WireFormat format) {
+    switch (format) {
+        case WireFormat::Cbor:
+            return nlohmann::json::from_cbor(payload);
+        case WireFormat::MessagePack:
+            return nlohmann::json::from_msgpack(payload);
+        case WireFormat::Json:
+        default:
+            return nlohmann::json::parse(payload);
+    }
+}
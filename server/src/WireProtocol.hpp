@@ -0,0 +1,32 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+/// Message encodings a client can negotiate through Sec-WebSocket-Protocol.
+/// All of them carry the same JSON document model; binary formats just skip
+/// the text parsing and serialization.
+enum class WireFormat {
+    Json,
+    Cbor,
+    MessagePack
+};
+
+class WireProtocol {
+public:
+    static const char* const JSON_SUBPROTOCOL;
+    static const char* const CBOR_SUBPROTOCOL;
+    static const char* const MSGPACK_SUBPROTOCOL;
+
+    // Pick the first supported subprotocol in the client's preference order.
+    // Returns false if none of them is supported, leaving JSON as the default.
+    static bool negotiate(const std::vector<std::string>& requested, std::string& selected);
+    static WireFormat fromSubprotocol(const std::string& subprotocol);
+
+    static bool isBinary(WireFormat format) { return format != WireFormat::Json; }
+
+    static std::string encode(const nlohmann::json& message, WireFormat format);
+    // Throws nlohmann::json::exception on malformed input
+    static nlohmann::json decode(const std::string& payload, WireFormat format);
+};
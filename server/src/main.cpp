@@ -1,30 +1,71 @@
 #include "WebSocketServer.hpp"
+#include "Logger.hpp"
+#include <cstdlib>
 #include <iostream>
+#include <string>
 #include <thread>
 
 int main() {
+    Logger& logger = Logger::instance();
+    if (const char* level_env = std::getenv("BRASS_LOG_LEVEL")) {
+        LogLevel level;
+        if (Logger::parseLevel(level_env, level)) {
+            logger.setLevel(level);
+        } else {
+            std::cerr << "Unknown BRASS_LOG_LEVEL '" << level_env << "', using info" << std::endl;
+        }
+    }
+    logger.start();
+
+    size_t io_threads = std::thread::hardware_concurrency();
+    if (const char* threads_env = std::getenv("BRASS_IO_THREADS")) {
+        io_threads = std::strtoul(threads_env, nullptr, 10);
+    }
+    if (io_threads == 0) {
+        io_threads = 1;
+    }
+
+    ServerOptions options;
+    if (const char* deflate_env = std::getenv("BRASS_DEFLATE")) {
+        options.deflate.enabled = std::string(deflate_env) != "off" && std::string(deflate_env) != "0";
+    }
+    if (const char* level_env = std::getenv("BRASS_DEFLATE_LEVEL")) {
+        options.deflate.level = std::atoi(level_env);
+        if (options.deflate.level < -1 || options.deflate.level > 9) {
+            LOG_WARN("main", "BRASS_DEFLATE_LEVEL must be between -1 and 9, using default");
+            options.deflate.level = -1;
+        }
+    }
+    if (const char* takeover_env = std::getenv("BRASS_DEFLATE_CONTEXT_TAKEOVER")) {
+        options.deflate.server_no_context_takeover = std::string(takeover_env) == "0";
+    }
+    if (const char* threshold_env = std::getenv("BRASS_DEFLATE_THRESHOLD")) {
+        options.compression_threshold = std::strtoul(threshold_env, nullptr, 10);
+    }
+
     try {
-        WebSocketServer server;
-        std::thread server_thread([&server]() {
-            server.run(9002);
+        WebSocketServer server(options);
+        std::thread server_thread([&server, io_threads]() {
+            server.run(9002, io_threads);
         });
 
-        std::cout << "Server running. Press 'q' to quit." << std::endl;
+        LOG_INFO("main", "Server running. Press 'q' to quit.");
         char input;
         do {
             std::cin >> input;
         } while (input != 'q');
 
-        std::cout << "Shutting down server..." << std::endl;
+        LOG_INFO("main", "Shutting down server...");
         server.stop();
         server_thread.join();
-        std::cout << "Server stopped." << std::endl;
+        LOG_INFO("main", "Server stopped.");
     } catch (websocketpp::exception const & e) {
-        std::cout << "WebSocket++ exception: " << e.what() << std::endl;
+        LOG_ERROR("main", "WebSocket++ exception: " << e.what());
     } catch (const std::exception& e) {
-        std::cout << "Standard exception: " << e.what() << std::endl;
+        LOG_ERROR("main", "Standard exception: " << e.what());
     } catch (...) {
-        std::cout << "Unknown exception" << std::endl;
+        LOG_ERROR("main", "Unknown exception");
     }
+    logger.stop();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,71 @@
+#include "Simulator.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+    void usage(const char* program) {
+        std::cerr << "Usage: " << program
+                  << " [--games N] [--threads N] [--seed N] [--players 2-4] [--policy random|heuristic]" << std::endl;
+    }
+}
+
+// Plays games without the WebSocket layer and reports rules engine
+// throughput. Exits with 1 if any game threw.
+int main(int argc, char** argv) {
+    SimOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        const char* value = argv[++i];
+        if (arg == "--games") {
+            options.games = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--threads") {
+            options.threads = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--players") {
+            options.players = std::atoi(value);
+        } else if (arg == "--policy" && std::strcmp(value, "random") == 0) {
+            options.policy = SimPolicy::Random;
+        } else if (arg == "--policy" && std::strcmp(value, "heuristic") == 0) {
+            options.policy = SimPolicy::Heuristic;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.players < 2 || options.players > 4) {
+        std::cerr << "--players must be between 2 and 4" << std::endl;
+        return 2;
+    }
+
+    SimStats stats = runSimulation(options);
+
+    std::cout << "games:   " << stats.games << " in " << stats.seconds << " s (" << stats.gamesPerSecond()
+              << " games/s)" << std::endl;
+    std::cout << "actions: " << stats.actions() << " accepted (" << stats.actionsPerSecond() << " actions/s), "
+              << stats.rejections() << " rejected, " << stats.passes << " passes" << std::endl;
+    for (size_t i = 0; i < SimStats::ACTION_TYPES; i++) {
+        uint64_t attempts = stats.accepted[i] + stats.rejected[i];
+        if (attempts == 0) {
+            continue;
+        }
+        std::cout << "  " << toString(static_cast<GameAction::Type>(i)) << ": " << stats.accepted[i]
+                  << " accepted, " << stats.rejected[i] << " rejected (" << 100.0 * stats.rejected[i] / attempts
+                  << "%)" << std::endl;
+    }
+    if (!stats.failed_seeds.empty()) {
+        std::cout << "failed seeds:";
+        for (uint64_t seed : stats.failed_seeds) {
+            std::cout << " " << seed;
+        }
+        std::cout << std::endl;
+        return 1;
+    }
+    return 0;
+}
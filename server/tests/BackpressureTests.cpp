@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include "Backpressure.hpp"
+
+using namespace std::chrono;
+
+TEST(BackpressureTest, AdmitsUntilLimit)
+{
+    Backpressure backpressure(1000, seconds(5));
+    OutboundState state;
+    auto now = Backpressure::clock::now();
+
+    EXPECT_TRUE(backpressure.admit(state, 0, 5000, now));
+    EXPECT_TRUE(backpressure.admit(state, 400, 600, now));
+    EXPECT_FALSE(state.stale);
+
+    EXPECT_FALSE(backpressure.admit(state, 900, 200, now));
+    EXPECT_TRUE(state.stale);
+    // Once stale nothing else is queued, even after the buffer drained
+    EXPECT_FALSE(backpressure.admit(state, 0, 10, now));
+}
+
+TEST(BackpressureTest, ResyncsOnceDrained)
+{
+    Backpressure backpressure(1000, seconds(5));
+    OutboundState state;
+    auto now = Backpressure::clock::now();
+
+    EXPECT_EQ(backpressure.poll(state, 5000, now), Backpressure::Action::None);
+    ASSERT_FALSE(backpressure.admit(state, 900, 200, now));
+
+    EXPECT_EQ(backpressure.poll(state, 800, now + seconds(1)), Backpressure::Action::None);
+    EXPECT_EQ(backpressure.poll(state, 500, now + seconds(2)), Backpressure::Action::Resync);
+    EXPECT_FALSE(state.stale);
+    EXPECT_TRUE(backpressure.admit(state, 500, 100, now + seconds(2)));
+}
+
+TEST(BackpressureTest, DisconnectsSlowConsumers)
+{
+    Backpressure backpressure(1000, seconds(5));
+    OutboundState state;
+    auto now = Backpressure::clock::now();
+
+    ASSERT_FALSE(backpressure.admit(state, 2000, 100, now));
+    EXPECT_EQ(backpressure.poll(state, 2000, now + seconds(4)), Backpressure::Action::None);
+    EXPECT_EQ(backpressure.poll(state, 2000, now + seconds(5)), Backpressure::Action::Disconnect);
+    // Reported once only
+    EXPECT_EQ(backpressure.poll(state, 2000, now + seconds(6)), Backpressure::Action::None);
+}
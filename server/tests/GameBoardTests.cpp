@@ -2,6 +2,7 @@
 #include <string>
 #include <algorithm>
 #include <memory>
+#include <set>
 #include "GameBoard.hpp"
 #include "GameState.hpp"
 #include "TileFactory.hpp"
@@ -20,6 +21,10 @@ protected:
         board.initializeBrassBirminghamMap();
     }
 
+    CityId id(const std::string& name) const {
+        return board.getCityId(name);
+    }
+
     Tile createTestTile(TileType type, int lvl, int owner) {
         return TileFactory::createTile(type, lvl, owner);
     }
@@ -39,27 +44,27 @@ protected:
         board.addConnection("CityD", "CityE");
 
 
-        board.placeLink("CityA", "CityB", player1);
-        board.placeLink("CityB", "CityC", player2);
-        board.placeLink("CityB", "CityD", player1);
+        board.placeLink(id("CityA"), id("CityB"), player1->id);
+        board.placeLink(id("CityB"), id("CityC"), player2->id);
+        board.placeLink(id("CityB"), id("CityD"), player1->id);
     }
 
     void placeLinks(const std::vector<std::tuple<std::string, std::string, std::shared_ptr<Player>>>& links) {
         for (const auto& [city1, city2, player] : links) {
-            ASSERT_TRUE(board.placeLink(city1, city2, player));
+            ASSERT_TRUE(board.placeLink(id(city1), id(city2), player->id));
         }
     }
 
     void addSlots(const std::vector<std::tuple<std::string, TileType>>& slots) {
         for (const auto& [city, tileType] : slots) {
-            board.addSlot(city, {{tileType}, nullptr});
+            board.addSlot(city, {{tileType}});
         }
     }
 
     void placeMerchantTiles(const std::vector<std::tuple<std::string, int, MerchantType>>& merchantTiles) {
         for (const auto& [city, slotIndex, merchantType] : merchantTiles) {
             MerchantTile merchantTile(merchantType);
-            ASSERT_TRUE(board.placeTile(city, slotIndex, merchantTile));
+            ASSERT_TRUE(board.placeTile(id(city), slotIndex, merchantTile));
         }
     }
 };
@@ -99,124 +104,140 @@ TEST_F(GameBoardTest, TileProperties2) {
 
 TEST_F(GameBoardTest, AddConnection) {
     board.addConnection("CityA", "CityB");
-    auto connections = board.getConnections("CityA");
-    ASSERT_EQ(connections.size(), 1);
-    ASSERT_EQ(connections[0], "CityB");
+    auto connections = board.getConnections(id("CityA"));
+    ASSERT_EQ(connections.size(), 1u);
+    ASSERT_EQ(connections[0], id("CityB"));
+}
+
+TEST_F(GameBoardTest, AdjacencyTracksLateAdditions) {
+    board.addConnection("CityA", "CityB");
+    board.addCity("CityC");
+    board.addConnection("CityC", "CityA");
+    board.addConnection("CityA", "CityB"); // Duplicate, ignored
+
+    auto connections = board.getConnections(id("CityA"));
+    ASSERT_EQ(connections.size(), 2u);
+    EXPECT_TRUE(std::find(connections.begin(), connections.end(), id("CityB")) != connections.end());
+    EXPECT_TRUE(std::find(connections.begin(), connections.end(), id("CityC")) != connections.end());
+    EXPECT_EQ(board.getConnections(id("CityC")), std::vector<CityId>{id("CityA")});
+
+    ASSERT_TRUE(board.placeLink(id("CityC"), id("CityA"), player1->id));
+    EXPECT_EQ(board.getConnectedCities(id("CityA")).size(), 2u);
+    EXPECT_FALSE(board.placeLink(id("CityB"), id("CityC"), player1->id));
 }
 
 TEST_F(GameBoardTest, PlaceLink) {
     board.addConnection("CityA", "CityB");
-    ASSERT_TRUE(board.placeLink("CityA", "CityB", player1));
-    ASSERT_FALSE(board.placeLink("CityA", "CityB", player2)); // Already placed
-    ASSERT_FALSE(board.placeLink("CityA", "CityC", player1)); // Non-existent connection
+    ASSERT_TRUE(board.placeLink(id("CityA"), id("CityB"), player1->id));
+    ASSERT_FALSE(board.placeLink(id("CityA"), id("CityB"), player2->id)); // Already placed
+    ASSERT_FALSE(board.placeLink(id("CityA"), id("CityC"), player1->id)); // Non-existent connection
 }
 
 TEST_F(GameBoardTest, GetPlacedConnections) {
     board.addConnection("CityA", "CityB");
     board.addConnection("CityB", "CityC");
-    board.placeLink("CityA", "CityB", player1);
+    board.placeLink(id("CityA"), id("CityB"), player1->id);
 
     auto placedConnections = board.getPlacedLinks();
-    ASSERT_EQ(placedConnections.size(), 1);
-    ASSERT_EQ(placedConnections[0].city1, "CityA");
-    ASSERT_EQ(placedConnections[0].city2, "CityB");
-    ASSERT_EQ(placedConnections[0].linkOwner, player1);
+    ASSERT_EQ(placedConnections.size(), 1u);
+    ASSERT_EQ(placedConnections[0].city1, id("CityA"));
+    ASSERT_EQ(placedConnections[0].city2, id("CityB"));
+    ASSERT_EQ(placedConnections[0].linkOwner, player1->id);
 }
 
 TEST_F(GameBoardTest, InitializedMapConnections) {
     board.initializeBrassBirminghamMap();
-    auto birminghamConnections = board.getConnections("Birmingham");
-    ASSERT_EQ(birminghamConnections.size(), 6);
+    auto birminghamConnections = board.getConnections(id("Birmingham"));
+    ASSERT_EQ(birminghamConnections.size(), 6u);
 
     std::vector<std::string> expectedConnections = {"Dudley", "Walsall", "Coventry","Oxford", "Worcester", "Tamworth"};
     
     for (const auto& expectedCity : expectedConnections) {
-        ASSERT_TRUE(std::find(birminghamConnections.begin(), birminghamConnections.end(), expectedCity) != birminghamConnections.end())
+        ASSERT_TRUE(std::find(birminghamConnections.begin(), birminghamConnections.end(), id(expectedCity)) != birminghamConnections.end())
             << "Expected connection to " << expectedCity << " not found";
     }
 }
 
 TEST_F(GameBoardTest, GetConnectedCities) {
     setupSimpleGameBoard();
-    board.addSlot("CityA", {{TileType::Coal, TileType::Iron}, nullptr});
+    board.addSlot("CityA", {{TileType::Coal, TileType::Iron}});
     // Place links
 
     // Test connected cities from CityA
-    std::vector<std::string> connectedCities = board.getConnectedCities("CityA");
-    ASSERT_EQ(connectedCities.size(), 4);
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityB") != connectedCities.end());
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityC") != connectedCities.end());
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityD") != connectedCities.end());
+    std::vector<CityId> connectedCities = board.getConnectedCities(id("CityA"));
+    ASSERT_EQ(connectedCities.size(), 4u);
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityB")) != connectedCities.end());
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityC")) != connectedCities.end());
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityD")) != connectedCities.end());
 
     // CityE should not be in the list as there's no link to it
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityE") == connectedCities.end());
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityE")) == connectedCities.end());
 
     // Test connected cities from CityD
-    connectedCities = board.getConnectedCities("CityD");
-    ASSERT_EQ(connectedCities.size(), 4);
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityA") != connectedCities.end());
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityB") != connectedCities.end());
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityC") != connectedCities.end());
+    connectedCities = board.getConnectedCities(id("CityD"));
+    ASSERT_EQ(connectedCities.size(), 4u);
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityA")) != connectedCities.end());
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityB")) != connectedCities.end());
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityC")) != connectedCities.end());
 
     // Place the last link
-    ASSERT_TRUE(board.placeLink("CityC", "CityE", player2));
+    ASSERT_TRUE(board.placeLink(id("CityC"), id("CityE"), player2->id));
 
     // Test connected cities from CityA again
-    connectedCities = board.getConnectedCities("CityA");
-    ASSERT_EQ(connectedCities.size(), 5);
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityB") != connectedCities.end());
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityC") != connectedCities.end());
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityD") != connectedCities.end());
-    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), "CityE") != connectedCities.end());
+    connectedCities = board.getConnectedCities(id("CityA"));
+    ASSERT_EQ(connectedCities.size(), 5u);
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityB")) != connectedCities.end());
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityC")) != connectedCities.end());
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityD")) != connectedCities.end());
+    EXPECT_TRUE(std::find(connectedCities.begin(), connectedCities.end(), id("CityE")) != connectedCities.end());
 }
 
 TEST_F(GameBoardTest, GetTotalResourceCoal) {
     setupSimpleGameBoard();
-    board.addSlot("CityA", {{TileType::Coal}, nullptr});
-    board.addSlot("CityB", {{TileType::Coal}, nullptr});
-    board.addSlot("CityC", {{TileType::Coal}, nullptr});
+    board.addSlot("CityA", {{TileType::Coal}});
+    board.addSlot("CityB", {{TileType::Coal}});
+    board.addSlot("CityC", {{TileType::Coal}});
 
     Tile Coal_a = createTestTile(TileType::Coal, 1, player1->id);
     Tile Coal_b = createTestTile(TileType::Coal, 1, player2->id);
 
-    ASSERT_TRUE(board.placeTile("CityA", 0, Coal_a));
-    ASSERT_TRUE(board.placeTile("CityC", 0, Coal_b));
+    ASSERT_TRUE(board.placeTile(id("CityA"), 0, Coal_a));
+    ASSERT_TRUE(board.placeTile(id("CityC"), 0, Coal_b));
 
-    int totalCoal = board.getTotalResourceCoal("CityA");
+    int totalCoal = board.getTotalResourceCoal(id("CityA"));
     ASSERT_EQ(totalCoal, Coal_a.resource_amount + Coal_b.resource_amount);
 
-    totalCoal = board.getTotalResourceCoal("CityC");
+    totalCoal = board.getTotalResourceCoal(id("CityC"));
     ASSERT_EQ(totalCoal, Coal_a.resource_amount + Coal_b.resource_amount);
-    totalCoal = board.getTotalResourceCoal("CityE");
+    totalCoal = board.getTotalResourceCoal(id("CityE"));
     ASSERT_EQ(totalCoal, 0);
 }
 
 TEST_F(GameBoardTest, PlaceMerchantTile) {
     // Add a new city
     board.addMerchantCity("CityA", MerchantBonus::Points4);
-    board.addSlot("CityA", {{TileType::Merchant}, nullptr});
-    board.addSlot("CityA", {{TileType::Merchant}, nullptr});
+    board.addSlot("CityA", {{TileType::Merchant}});
+    board.addSlot("CityA", {{TileType::Merchant}});
 
     // Create a MerchantTile
     MerchantTile merchantTile(MerchantType::Cotton);
 
     // Place the merchant tile in CityA
-    ASSERT_TRUE(board.placeTile("CityA", 0, merchantTile));
+    ASSERT_TRUE(board.placeTile(id("CityA"), 0, merchantTile));
 
     // Verify that the tile was placed correctly
-    const auto& cities = board.getCities();
-    auto cityIt = cities.find("CityA");
-    ASSERT_NE(cityIt, cities.end());
-    const auto& city = cityIt->second;
+    const City* city = board.getCity(id("CityA"));
+    ASSERT_NE(city, nullptr);
     
-    const auto& placedTile = city->slots[0].placedTile;
+    ASSERT_EQ(city->slots.size(), 2u);
+    EXPECT_TRUE(city->merchant);
+
+    // The merchant type is stored on the tile itself
+    const Tile* placedTile = board.getPlacedTile(id("CityA"), 0);
     ASSERT_NE(placedTile, nullptr);
     ASSERT_EQ(placedTile->type, TileType::Merchant);
-
-    // Cast the placedTile to MerchantTile and check its properties
-    const MerchantTile* merchantTilePtr = dynamic_cast<const MerchantTile*>(placedTile.get());
-    ASSERT_NE(merchantTilePtr, nullptr);
-    ASSERT_EQ(merchantTilePtr->merchantType, MerchantType::Cotton);
+    ASSERT_EQ(placedTile->merchantType, MerchantType::Cotton);
+    EXPECT_EQ(board.getPlacedTile(id("CityA"), 1), nullptr);
 }
 
 TEST_F(GameBoardTest, GetConnectedMerchantCities) {
@@ -234,25 +255,59 @@ TEST_F(GameBoardTest, GetConnectedMerchantCities) {
     board.addConnection("CityD", "CityE");
 
     // Place links
-    ASSERT_TRUE(board.placeLink("CityA", "CityB", player1));
-    ASSERT_TRUE(board.placeLink("CityB", "CityC", player2));
-    ASSERT_TRUE(board.placeLink("CityC", "CityD", player1));
-
-    std::vector<const MerchantCity*> connectedMerchantCities = board.getConnectedMerchantCities("CityA");
-    ASSERT_EQ(connectedMerchantCities.size(), 2);
-    EXPECT_EQ(connectedMerchantCities[0]->name, "CityB");
-    EXPECT_EQ(connectedMerchantCities[0]->merchant_bonus, MerchantBonus::Points4);
-    EXPECT_EQ(connectedMerchantCities[1]->name, "CityD");
-    EXPECT_EQ(connectedMerchantCities[1]->merchant_bonus, MerchantBonus::Income2);
-
-    connectedMerchantCities = board.getConnectedMerchantCities("CityE");
-    ASSERT_EQ(connectedMerchantCities.size(), 0);
-
-    ASSERT_TRUE(board.placeLink("CityD", "CityE", player2));
-    connectedMerchantCities = board.getConnectedMerchantCities("CityE");
-    ASSERT_EQ(connectedMerchantCities.size(), 2);
-    EXPECT_EQ(connectedMerchantCities[0]->name, "CityD");
-    EXPECT_EQ(connectedMerchantCities[1]->name, "CityB");
+    ASSERT_TRUE(board.placeLink(id("CityA"), id("CityB"), player1->id));
+    ASSERT_TRUE(board.placeLink(id("CityB"), id("CityC"), player2->id));
+    ASSERT_TRUE(board.placeLink(id("CityC"), id("CityD"), player1->id));
+
+    std::vector<CityId> connectedMerchantCities = board.getConnectedMerchantCities(id("CityA"));
+    std::sort(connectedMerchantCities.begin(), connectedMerchantCities.end());
+    ASSERT_EQ(connectedMerchantCities.size(), 2u);
+    EXPECT_EQ(board.getCityName(connectedMerchantCities[0]), "CityB");
+    EXPECT_EQ(board.getMerchantCity(connectedMerchantCities[0])->merchant_bonus, MerchantBonus::Points4);
+    EXPECT_EQ(board.getCityName(connectedMerchantCities[1]), "CityD");
+    EXPECT_EQ(board.getMerchantCity(connectedMerchantCities[1])->merchant_bonus, MerchantBonus::Income2);
+
+    connectedMerchantCities = board.getConnectedMerchantCities(id("CityE"));
+    ASSERT_EQ(connectedMerchantCities.size(), 0u);
+
+    ASSERT_TRUE(board.placeLink(id("CityD"), id("CityE"), player2->id));
+    connectedMerchantCities = board.getConnectedMerchantCities(id("CityE"));
+    ASSERT_EQ(connectedMerchantCities.size(), 2u);
+    // Order follows component merges, not distance
+    std::set<std::string> names;
+    for (CityId merchantCity : connectedMerchantCities)
+        names.insert(board.getCityName(merchantCity));
+    EXPECT_EQ(names, (std::set<std::string>{"CityB", "CityD"}));
+}
+
+TEST_F(GameBoardTest, ComponentsFollowPlacedLinks) {
+    for (const char* name : {"CityA", "CityB", "CityC", "CityD", "CityE"})
+        board.addCity(name);
+    board.addConnection("CityA", "CityB");
+    board.addConnection("CityB", "CityC");
+    board.addConnection("CityB", "CityD");
+    board.addConnection("CityD", "CityE");
+
+    EXPECT_FALSE(board.areConnected(id("CityA"), id("CityB")));
+    ASSERT_TRUE(board.placeLink(id("CityA"), id("CityB"), player1->id));
+    ASSERT_TRUE(board.placeLink(id("CityD"), id("CityE"), player2->id));
+    EXPECT_TRUE(board.areConnected(id("CityA"), id("CityB")));
+    EXPECT_FALSE(board.areConnected(id("CityB"), id("CityD")));
+
+    ASSERT_TRUE(board.placeLink(id("CityB"), id("CityD"), player1->id));
+    EXPECT_TRUE(board.areConnected(id("CityA"), id("CityE")));
+    EXPECT_EQ(board.getComponent(id("CityA")), board.getComponent(id("CityE")));
+    EXPECT_EQ(board.getComponentCities(board.getComponent(id("CityA"))).size(), 4u);
+    EXPECT_FALSE(board.areConnected(id("CityA"), id("CityC")));
+    EXPECT_FALSE(board.areConnected(id("CityA"), id("NonExistent")));
+
+    // Era change removes every link
+    board.clearLinks();
+    EXPECT_TRUE(board.getPlacedLinks().empty());
+    EXPECT_FALSE(board.areConnected(id("CityA"), id("CityB")));
+    EXPECT_TRUE(board.areConnected(id("CityA"), id("CityA")));
+    ASSERT_TRUE(board.placeLink(id("CityA"), id("CityB"), player2->id));
+    EXPECT_TRUE(board.areConnected(id("CityA"), id("CityB")));
 }
 
 TEST_F(GameBoardTest, IsConnectedToMerchantCity) {
@@ -270,28 +325,28 @@ TEST_F(GameBoardTest, IsConnectedToMerchantCity) {
     board.addConnection("CityD", "CityE");
 
     // Place links
-    ASSERT_TRUE(board.placeLink("CityA", "CityB", player1));
-    ASSERT_TRUE(board.placeLink("CityB", "CityC", player2));
-    ASSERT_TRUE(board.placeLink("CityC", "CityD", player1));
+    ASSERT_TRUE(board.placeLink(id("CityA"), id("CityB"), player1->id));
+    ASSERT_TRUE(board.placeLink(id("CityB"), id("CityC"), player2->id));
+    ASSERT_TRUE(board.placeLink(id("CityC"), id("CityD"), player1->id));
 
     // Test city directly connected to a merchant city
-    EXPECT_TRUE(board.isConnectedToMerchantCity("CityA"));
+    EXPECT_TRUE(board.isConnectedToMerchantCity(id("CityA")));
 
     // Test city indirectly connected to a merchant city
-    EXPECT_TRUE(board.isConnectedToMerchantCity("CityC"));
+    EXPECT_TRUE(board.isConnectedToMerchantCity(id("CityC")));
 
     // Test city not connected to any merchant city
-    EXPECT_FALSE(board.isConnectedToMerchantCity("CityE"));
+    EXPECT_FALSE(board.isConnectedToMerchantCity(id("CityE")));
 
     // Connect CityE and test again
-    ASSERT_TRUE(board.placeLink("CityD", "CityE", player2));
-    EXPECT_TRUE(board.isConnectedToMerchantCity("CityE"));
+    ASSERT_TRUE(board.placeLink(id("CityD"), id("CityE"), player2->id));
+    EXPECT_TRUE(board.isConnectedToMerchantCity(id("CityE")));
 
     // Test a merchant city itself
-    EXPECT_TRUE(board.isConnectedToMerchantCity("CityB"));
+    EXPECT_TRUE(board.isConnectedToMerchantCity(id("CityB")));
 
     // Test with a non-existent city (should return false)
-    EXPECT_FALSE(board.isConnectedToMerchantCity("NonExistentCity"));
+    EXPECT_FALSE(board.isConnectedToMerchantCity(id("NonExistentCity")));
 }
 
 TEST_F(GameBoardTest, GetConnectedMerchantTypes) {
@@ -309,36 +364,36 @@ TEST_F(GameBoardTest, GetConnectedMerchantTypes) {
     board.addConnection("CityD", "CityE");
 
     // Place links
-    ASSERT_TRUE(board.placeLink("CityA", "CityB", player1));
-    ASSERT_TRUE(board.placeLink("CityB", "CityC", player2));
-    ASSERT_TRUE(board.placeLink("CityC", "CityD", player1));
+    ASSERT_TRUE(board.placeLink(id("CityA"), id("CityB"), player1->id));
+    ASSERT_TRUE(board.placeLink(id("CityB"), id("CityC"), player2->id));
+    ASSERT_TRUE(board.placeLink(id("CityC"), id("CityD"), player1->id));
 
     // Add slots to merchant cities
-    board.addSlot("CityB", {{TileType::Merchant}, nullptr});
-    board.addSlot("CityD", {{TileType::Merchant}, nullptr});
+    board.addSlot("CityB", {{TileType::Merchant}});
+    board.addSlot("CityD", {{TileType::Merchant}});
 
     // Create merchant tiles
     MerchantTile cottonMerchant(MerchantType::Cotton);
     MerchantTile potteryMerchant(MerchantType::Pottery);
 
     // Place merchant tiles
-    ASSERT_TRUE(board.placeTile("CityB", 0, cottonMerchant));
-    ASSERT_TRUE(board.placeTile("CityD", 0, potteryMerchant));
+    ASSERT_TRUE(board.placeTile(id("CityB"), 0, cottonMerchant));
+    ASSERT_TRUE(board.placeTile(id("CityD"), 0, potteryMerchant));
 
     // Test connected merchant types from CityA
-    std::set<MerchantType> connectedMerchantTypes = board.getConnectedMerchantTypes("CityA");
-    ASSERT_EQ(connectedMerchantTypes.size(), 2);
+    std::set<MerchantType> connectedMerchantTypes = board.getConnectedMerchantTypes(id("CityA"));
+    ASSERT_EQ(connectedMerchantTypes.size(), 2u);
     EXPECT_TRUE(connectedMerchantTypes.find(MerchantType::Cotton) != connectedMerchantTypes.end());
     EXPECT_TRUE(connectedMerchantTypes.find(MerchantType::Pottery) != connectedMerchantTypes.end());
 
     // Test connected merchant types from CityE (should be empty)
-    connectedMerchantTypes = board.getConnectedMerchantTypes("CityE");
-    ASSERT_EQ(connectedMerchantTypes.size(), 0);
+    connectedMerchantTypes = board.getConnectedMerchantTypes(id("CityE"));
+    ASSERT_EQ(connectedMerchantTypes.size(), 0u);
 
     // Connect CityE and test again
-    ASSERT_TRUE(board.placeLink("CityD", "CityE", player2));
-    connectedMerchantTypes = board.getConnectedMerchantTypes("CityE");
-    ASSERT_EQ(connectedMerchantTypes.size(), 2);
+    ASSERT_TRUE(board.placeLink(id("CityD"), id("CityE"), player2->id));
+    connectedMerchantTypes = board.getConnectedMerchantTypes(id("CityE"));
+    ASSERT_EQ(connectedMerchantTypes.size(), 2u);
     EXPECT_TRUE(connectedMerchantTypes.find(MerchantType::Cotton) != connectedMerchantTypes.end());
     EXPECT_TRUE(connectedMerchantTypes.find(MerchantType::Pottery) != connectedMerchantTypes.end());
 }
@@ -350,11 +405,11 @@ TEST_F(GameBoardTest, GetTotalResourceIron) {
     board.addCity("CityC");
 
     // Add slots that allow Iron tiles
-    board.addSlot("CityA", {{TileType::Iron}, nullptr});
-    board.addSlot("CityB", {{TileType::Coal}, nullptr});
-    board.addSlot("CityB", {{TileType::Iron}, nullptr});
-    board.addSlot("CityC", {{TileType::Iron}, nullptr});
-    board.addSlot("CityC", {{TileType::Iron}, nullptr});
+    board.addSlot("CityA", {{TileType::Iron}});
+    board.addSlot("CityB", {{TileType::Coal}});
+    board.addSlot("CityB", {{TileType::Iron}});
+    board.addSlot("CityC", {{TileType::Iron}});
+    board.addSlot("CityC", {{TileType::Iron}});
 
     // Create Iron tiles with different resource amounts
     Tile ironTile1 = createTestTile(TileType::Iron, 1, player1->id);
@@ -362,9 +417,9 @@ TEST_F(GameBoardTest, GetTotalResourceIron) {
     Tile ironTile3 = createTestTile(TileType::Iron, 3, player1->id);
 
     // Place the tiles
-    ASSERT_TRUE(board.placeTile("CityA", 0, ironTile1));
-    ASSERT_TRUE(board.placeTile("CityB", 1, ironTile2));
-    ASSERT_TRUE(board.placeTile("CityC", 0, ironTile3));
+    ASSERT_TRUE(board.placeTile(id("CityA"), 0, ironTile1));
+    ASSERT_TRUE(board.placeTile(id("CityB"), 1, ironTile2));
+    ASSERT_TRUE(board.placeTile(id("CityC"), 0, ironTile3));
 
     // Calculate expected total iron
     int expectedTotalIron = ironTile1.resource_amount + ironTile2.resource_amount + ironTile3.resource_amount;
@@ -375,41 +430,122 @@ TEST_F(GameBoardTest, GetTotalResourceIron) {
 
     // Add another iron tile and test again
     Tile ironTile4 = createTestTile(TileType::Iron, 2, player2->id);
-    ASSERT_TRUE(board.placeTile("CityC", 1, ironTile4));
+    ASSERT_TRUE(board.placeTile(id("CityC"), 1, ironTile4));
 
     expectedTotalIron += ironTile4.resource_amount;
     totalIron = board.getTotalResourceIron();
     ASSERT_EQ(totalIron, expectedTotalIron);
 }
 
+TEST_F(GameBoardTest, ResourceIndexTracksConsumption) {
+    board.addCity("CityA");
+    board.addCity("CityB");
+    board.addSlot("CityA", {{TileType::Iron}});
+    board.addSlot("CityB", {{TileType::Cotton}});
+    board.addSlot("CityB", {{TileType::Iron}});
+
+    Tile ironTile1 = createTestTile(TileType::Iron, 1, player1->id);
+    Tile ironTile2 = createTestTile(TileType::Iron, 1, player2->id);
+    ASSERT_TRUE(board.placeTile(id("CityA"), 0, ironTile1));
+    ASSERT_TRUE(board.placeTile(id("CityB"), 1, ironTile2));
+    ASSERT_EQ(board.getResourceSlots(TileType::Iron).size(), 2u);
+    int total = ironTile1.resource_amount + ironTile2.resource_amount;
+    EXPECT_EQ(board.getResourceTotal(TileType::Iron), total);
+
+    // Taking more than a tile holds empties it and drops it from the index
+    EXPECT_EQ(board.consumeResource(id("CityA"), 0, 100), ironTile1.resource_amount);
+    EXPECT_EQ(board.getPlacedTile(id("CityA"), 0)->resource_amount, 0);
+    ASSERT_EQ(board.getResourceSlots(TileType::Iron).size(), 1u);
+    EXPECT_EQ(board.getResourceSlots(TileType::Iron)[0].city, id("CityB"));
+    EXPECT_EQ(board.getTotalResourceIron(), ironTile2.resource_amount);
+
+    EXPECT_EQ(board.consumeResource(id("CityB"), 1, 1), 1);
+    EXPECT_EQ(board.getTotalResourceIron(), ironTile2.resource_amount - 1);
+    EXPECT_EQ(board.consumeResource(id("CityA"), 0, 1), 0);
+    EXPECT_EQ(board.consumeResource(id("CityB"), 0, 1), 0);
+    EXPECT_TRUE(board.getResourceSlots(TileType::Cotton).empty());
+}
+
+TEST_F(GameBoardTest, FindSellableTilesPerComponent) {
+    board.addCity("CityA");
+    board.addCity("CityB");
+    board.addMerchantCity("Market", MerchantBonus::Points4);
+    board.addConnection("CityA", "Market");
+    board.addConnection("CityB", "Market");
+    addSlots({{"CityA", TileType::Pottery}, {"CityA", TileType::Brewery},
+              {"CityB", TileType::Pottery}, {"CityB", TileType::Brewery},
+              {"Market", TileType::Merchant}});
+
+    // Level 3 pottery needs two beer
+    ASSERT_TRUE(board.placeTile(id("CityA"), 0, createTestTile(TileType::Pottery, 3, player1->id)));
+    ASSERT_TRUE(board.placeTile(id("CityA"), 1, createTestTile(TileType::Brewery, 1, player1->id)));
+    ASSERT_TRUE(board.placeTile(id("CityB"), 0, createTestTile(TileType::Pottery, 1, player1->id)));
+    ASSERT_TRUE(board.placeTile(id("Market"), 0, MerchantTile(MerchantType::Pottery)));
+
+    // Not linked to the merchant yet
+    EXPECT_TRUE(board.findSellableTiles(*player1).empty());
+
+    ASSERT_TRUE(board.placeLink(id("CityA"), id("Market"), player1->id));
+    // The brewery in CityA holds one beer and must only be counted once
+    EXPECT_TRUE(board.findSellableTiles(*player1).empty());
+
+    ASSERT_TRUE(board.placeLink(id("CityB"), id("Market"), player1->id));
+    auto sellable = board.findSellableTiles(*player1);
+    ASSERT_EQ(sellable.size(), 1u);
+    EXPECT_EQ(sellable[0], std::make_pair(id("CityB"), 0));
+
+    ASSERT_TRUE(board.placeTile(id("CityB"), 1, createTestTile(TileType::Brewery, 1, player2->id)));
+    sellable = board.findSellableTiles(*player1);
+    ASSERT_EQ(sellable.size(), 2u);
+    EXPECT_EQ(sellable[0], std::make_pair(id("CityA"), 0));
+    EXPECT_TRUE(board.findSellableTiles(*player2).empty());
+}
+
 TEST_F(GameBoardTest, IsCityInPlayerNetwork) {
     // Setup
     setupSimpleGameBoard();
     // Place links and tiles for players
     // Place tiles (assuming a placeTile method exists)
-    board.addSlot("CityE",{{TileType::Coal}, nullptr}); 
-    board.addSlot("CityE",{{TileType::Coal}, nullptr}); 
+    board.addSlot("CityE",{{TileType::Coal}}); 
+    board.addSlot("CityE",{{TileType::Coal}}); 
     Tile testTile = createTestTile(TileType::Coal, 1, player1->id);
-    ASSERT_TRUE(board.placeTile("CityE", 0, testTile));
+    ASSERT_TRUE(board.placeTile(id("CityE"), 0, testTile));
     // Test cases
-    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, "CityA"));
-    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, "CityB"));
-    EXPECT_FALSE(board.isCityInPlayerNetwork(*player1, "CityC"));
-    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, "CityE"));
-    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, "CityD"));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, id("CityA")));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, id("CityB")));
+    EXPECT_FALSE(board.isCityInPlayerNetwork(*player1, id("CityC")));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, id("CityE")));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, id("CityD")));
     
-    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, "CityC"));
-    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, "CityD"));
-    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, "CityA"));
-    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, "CityB"));
-    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, "CityE"));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, id("CityC")));
+    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, id("CityD")));
+    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, id("CityA")));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, id("CityB")));
+    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, id("CityE")));
 
     testTile = createTestTile(TileType::Coal, 1, player2->id);
-    ASSERT_TRUE(board.placeTile("CityE", 1, testTile));
-    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, "CityE"));
+    ASSERT_TRUE(board.placeTile(id("CityE"), 1, testTile));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, id("CityE")));
 
     //None existent city
-    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, "NonExistent"));
+    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, id("NonExistent")));
+}
+
+TEST_F(GameBoardTest, PlayerNetworkFollowsClearedLinks) {
+    setupSimpleGameBoard();
+    addSlots({{"CityE", TileType::Coal}});
+    Tile testTile = createTestTile(TileType::Coal, 1, player2->id);
+    ASSERT_TRUE(board.placeTile(id("CityE"), 0, testTile));
+
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, id("CityD")));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, id("CityC")));
+
+    board.clearLinks();
+    // player1 only had links, so the whole map is open again
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, id("CityC")));
+    // player2 keeps the city of its tile
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, id("CityE")));
+    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, id("CityC")));
 }
 
 TEST_F(GameBoardTest, IsCityNetworkWhenNoTilesPlace) {
@@ -418,9 +554,86 @@ TEST_F(GameBoardTest, IsCityNetworkWhenNoTilesPlace) {
     board.addCity("CityB");
     board.addCity("CityC");
 
-    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, "CityA"));
-    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, "CityB"));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, id("CityA")));
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player2, id("CityB")));
 }
 
+TEST_F(GameBoardTest, UndoSplitsMergedComponents) {
+    board.addMerchantCity("CityA", MerchantBonus::Points4);
+    board.addCity("CityB");
+    board.addCity("CityC");
+    board.addMerchantCity("CityD", MerchantBonus::Income2);
+    board.addConnection("CityA", "CityB");
+    board.addConnection("CityB", "CityC");
+    board.addConnection("CityC", "CityD");
+    ASSERT_TRUE(board.placeLink(id("CityC"), id("CityD"), player2->id));
+
+    board.setRecording(true);
+    size_t mark = board.getUndoMark();
+    ASSERT_TRUE(board.placeLink(id("CityA"), id("CityB"), player1->id));
+    ASSERT_TRUE(board.placeLink(id("CityB"), id("CityC"), player1->id));
+    EXPECT_EQ(board.getComponentCities(board.getComponent(id("CityA"))).size(), 4u);
+    EXPECT_EQ(board.getConnectedMerchantCities(id("CityB")).size(), 2u);
+
+    std::vector<std::pair<CityId, int>> slots;
+    std::vector<std::pair<CityId, CityId>> links;
+    board.undoTo(mark, slots, links);
+    EXPECT_EQ(links.size(), 2u);
+    EXPECT_FALSE(board.areConnected(id("CityA"), id("CityB")));
+    EXPECT_TRUE(board.areConnected(id("CityC"), id("CityD")));
+    EXPECT_EQ(board.getComponentCities(board.getComponent(id("CityB"))), std::vector<CityId>{id("CityB")});
+    EXPECT_EQ(board.getComponentCities(board.getComponent(id("CityC"))).size(), 2u);
+    EXPECT_TRUE(board.getConnectedMerchantCities(id("CityB")).empty());
+    EXPECT_EQ(board.getConnectedMerchantCities(id("CityA")), std::vector<CityId>{id("CityA")});
+    EXPECT_EQ(board.getConnectedMerchantCities(id("CityC")), std::vector<CityId>{id("CityD")});
+    // player1's only links are gone, so its network is the whole map again
+    EXPECT_TRUE(board.isCityInPlayerNetwork(*player1, id("CityD")));
+    EXPECT_FALSE(board.isCityInPlayerNetwork(*player2, id("CityB")));
+
+    // The split components merge again like fresh ones
+    ASSERT_TRUE(board.placeLink(id("CityB"), id("CityC"), player1->id));
+    EXPECT_EQ(board.getConnectedMerchantCities(id("CityB")), std::vector<CityId>{id("CityD")});
+    EXPECT_FALSE(board.isCityInPlayerNetwork(*player1, id("CityA")));
+}
+
+
+
 
+TEST_F(GameBoardTest, CopiesAreIndependent) {
+    board.initializeBrassBirminghamMap();
+    GameBoard copy = board;
+
+    ASSERT_TRUE(copy.placeTile(id("Stone"), 1, TileFactory::createTile(TileType::Coal, 1, player1->id)));
+    ASSERT_TRUE(copy.placeLink(id("Stone"), id("Stafford"), player1->id));
+    EXPECT_NE(copy.getPlacedTile(id("Stone"), 1), nullptr);
+    EXPECT_TRUE(copy.areConnected(id("Stone"), id("Stafford")));
+    EXPECT_EQ(copy.getResourceTotal(TileType::Coal), 2);
+
+    EXPECT_EQ(board.getPlacedTile(id("Stone"), 1), nullptr);
+    EXPECT_FALSE(board.areConnected(id("Stone"), id("Stafford")));
+    EXPECT_EQ(board.getResourceTotal(TileType::Coal), 0);
+    EXPECT_TRUE(board.getPlacedLinks().empty());
+    // Placing tiles and links leaves the map layout shared
+    EXPECT_EQ(copy.getCity(id("Stone")), board.getCity(id("Stone")));
+    // A map edit gives the editing board its own layout
+    copy.addSlot(id("Stone"), {{TileType::Coal}});
+    EXPECT_NE(copy.getCity(id("Stone")), board.getCity(id("Stone")));
+    EXPECT_EQ(board.getCity(id("Stone"))->slots.size(), 2u);
+    EXPECT_EQ(copy.getPlacedTile(id("Stone"), 1)->type, TileType::Coal);
+}
 
+TEST_F(GameBoardTest, AddSlotKeepsPlacedTiles) {
+    board.addCity("CityA");
+    board.addCity("CityB");
+    board.addSlot("CityA", {{TileType::Coal}});
+    board.addSlot("CityB", {{TileType::Iron}});
+    ASSERT_TRUE(board.placeTile(id("CityB"), 0, createTestTile(TileType::Iron, 1, player1->id)));
+
+    // CityB's slots come after CityA's in the board's slot table
+    board.addSlot("CityA", {{TileType::Coal}});
+    EXPECT_EQ(board.getPlacedTile(id("CityA"), 0), nullptr);
+    EXPECT_EQ(board.getPlacedTile(id("CityA"), 1), nullptr);
+    ASSERT_NE(board.getPlacedTile(id("CityB"), 0), nullptr);
+    EXPECT_EQ(board.getPlacedTile(id("CityB"), 0)->type, TileType::Iron);
+    EXPECT_TRUE(board.canPlaceTile(id("CityA"), 1, createTestTile(TileType::Coal, 1, player1->id)));
+}
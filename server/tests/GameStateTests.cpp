@@ -2,12 +2,18 @@
 #include "Tile.hpp"
 #include "TileFactory.hpp"
 #include <gtest/gtest.h>
+#include <random>
 
 class GameStateTest : public ::testing::Test
 {
 protected:
     GameState gameState;
 
+    CityId id(const std::string &name) const
+    {
+        return gameState.m_board.getCityId(name);
+    }
+
     // Helper function to create a tile for testing
     Tile createTestTile(TileType type, int owner)
     {
@@ -42,7 +48,7 @@ TEST_F(GameStateTest, PlaceSimpleTile)
 
     GameAction action;
     action.type = GameAction::Type::PlaceTile;
-    action.cityName = "Birmingham";
+    action.city = id("Birmingham");
     action.slotIndex = 0;
     action.tileType = TileType::Cotton;
 
@@ -63,7 +69,7 @@ TEST_F(GameStateTest, PlaceTileInOccupiedSlot)
 
     GameAction action;
     action.type = GameAction::Type::PlaceTile;
-    action.cityName = "Birmingham";
+    action.city = id("Birmingham");
     action.slotIndex = 0;
     action.tileType = TileType::Cotton;
 
@@ -77,7 +83,7 @@ TEST_F(GameStateTest, PlaceTileInInvalidSlot)
 
     GameAction action;
     action.type = GameAction::Type::PlaceTile;
-    action.cityName = "Birmingham";
+    action.city = id("Birmingham");
     action.slotIndex = 1; // coal not allowed
     action.tileType = TileType::Coal;
 
@@ -92,34 +98,34 @@ TEST_F(GameStateTest, placeLinkTile)
 
     GameAction action;
     action.type = GameAction::Type::PlaceLink;
-    action.cityName = "Birmingham";
-    action.cityName2 = "Coventry";
+    action.city = id("Birmingham");
+    action.city2 = id("Coventry");
     bool first_placed_link = gameState.handleAction(player->id, action);
     EXPECT_TRUE(first_placed_link);
 
-    action.cityName = "Derby";
-    action.cityName2 = "Conventry";
+    action.city = id("Derby");
+    action.city2 = id("Conventry");
     bool impossible_link = gameState.handleAction(player->id, action);
     EXPECT_FALSE(impossible_link);
-    action.cityName = "Stone";
-    action.cityName2 = "Stafford";
+    action.city = id("Stone");
+    action.city2 = id("Stafford");
     bool not_in_player_network = gameState.handleAction(player->id, action);
     EXPECT_FALSE(not_in_player_network);
-    action.cityName = "Dudley";
-    action.cityName2 = "Birmingham";
+    action.city = id("Dudley");
+    action.city2 = id("Birmingham");
     bool in_player_network_by_connection = gameState.handleAction(player->id, action);
     EXPECT_TRUE(in_player_network_by_connection);
 
     action.type = GameAction::Type::PlaceTile;
-    action.cityName = "Stone";
+    action.city = id("Stone");
     action.tileType = TileType::Coal;
     action.slotIndex = 1;
 
     bool placed_tile = gameState.handleAction(player->id, action);
     EXPECT_TRUE(placed_tile);
     action.type = GameAction::Type::PlaceLink;
-    action.cityName = "Stone";
-    action.cityName2 = "Stafford";
+    action.city = id("Stone");
+    action.city2 = id("Stafford");
     bool in_player_network_by_tile = gameState.handleAction(player->id, action);
     EXPECT_TRUE(in_player_network_by_tile);
 }
@@ -148,8 +154,8 @@ TEST_F(GameStateTest, Develop)
 
     bool develop_action_result = gameState.handleAction(player->id, action);
     EXPECT_TRUE(develop_action_result);
-    Tile *irontile3 = player->player_board.peekTile(TileType::Iron).get();
-    EXPECT_EQ(irontile3->level, 3);
+    TileDescriptor irontile3 = player->player_board.peekTile(TileType::Iron);
+    EXPECT_EQ(irontile3.level, 3);
     EXPECT_EQ(player->money, 26);
 
     auto state = gameState.getState();
@@ -164,6 +170,382 @@ TEST_F(GameStateTest, RemovePlayer)
     gameState.removePlayer(player1->id);
 
     auto state = gameState.getState();
-    EXPECT_EQ(state["players"].size(), 1);
+    EXPECT_EQ(state["players"].size(), 1u);
     EXPECT_EQ(state["players"][0]["id"], player2->id);
 }
+
+TEST_F(GameStateTest, DeltaContainsOnlyChanges)
+{
+    auto player = gameState.addPlayer();
+    auto joinDelta = gameState.takeDelta();
+    EXPECT_EQ(joinDelta["seq"], 1);
+    ASSERT_EQ(joinDelta["players"].size(), 1u);
+    EXPECT_FALSE(gameState.hasPendingChanges());
+
+    GameAction action;
+    action.type = GameAction::Type::PlaceTile;
+    action.city = id("Birmingham");
+    action.slotIndex = 0;
+    action.tileType = TileType::Cotton;
+    ASSERT_TRUE(gameState.handleAction(player->id, action));
+    ASSERT_TRUE(gameState.hasPendingChanges());
+
+    auto delta = gameState.takeDelta();
+    EXPECT_EQ(delta["type"], "delta");
+    EXPECT_EQ(delta["seq"], 2);
+    ASSERT_EQ(delta["slots"].size(), 1u);
+    EXPECT_EQ(delta["slots"][0]["city"], "Birmingham");
+    EXPECT_EQ(delta["slots"][0]["slotIndex"], 0);
+    EXPECT_EQ(delta["slots"][0]["placedTile"]["type"], TileType::Cotton);
+    ASSERT_EQ(delta["players"].size(), 1u);
+    EXPECT_EQ(delta["players"][0]["money"], player->money);
+    EXPECT_TRUE(delta.contains("markets"));
+    EXPECT_EQ(gameState.getState()["seq"], 2);
+
+    gameState.removePlayer(player->id);
+    delta = gameState.takeDelta();
+    EXPECT_EQ(delta["players"].size(), 0u);
+    EXPECT_EQ(delta["removedPlayers"][0], player->id);
+}
+
+TEST_F(GameStateTest, DeltaContainsPlacedLink)
+{
+    auto player = gameState.addPlayer();
+    gameState.takeDelta();
+
+    GameAction action;
+    action.type = GameAction::Type::PlaceLink;
+    action.city = id("Coventry");
+    action.city2 = id("Birmingham");
+    ASSERT_TRUE(gameState.handleAction(player->id, action));
+
+    auto delta = gameState.takeDelta();
+    ASSERT_EQ(delta["connections"].size(), 1u);
+    EXPECT_EQ(delta["connections"][0]["city1"], "Birmingham");
+    EXPECT_EQ(delta["connections"][0]["owner"], player->id);
+    EXPECT_EQ(delta["slots"].size(), 0u);
+}
+
+TEST_F(GameStateTest, AdvanceEraClearsLinks)
+{
+    auto player = gameState.addPlayer();
+
+    GameAction action;
+    action.type = GameAction::Type::PlaceLink;
+    action.city = id("Coventry");
+    action.city2 = id("Birmingham");
+    ASSERT_TRUE(gameState.handleAction(player->id, action));
+    ASSERT_TRUE(gameState.m_board.areConnected(id("Coventry"), id("Birmingham")));
+    gameState.takeDelta();
+
+    gameState.advanceEra();
+    EXPECT_EQ(gameState.getEra(), ERA::RailRoad);
+    EXPECT_FALSE(gameState.m_board.areConnected(id("Coventry"), id("Birmingham")));
+    EXPECT_TRUE(gameState.m_board.getPlacedLinks().empty());
+
+    auto delta = gameState.takeDelta();
+    EXPECT_EQ(delta["era"], "rail");
+    EXPECT_EQ(delta["connections"].size(), 0u);
+    EXPECT_EQ(gameState.getState()["era"], "rail");
+}
+
+namespace
+{
+    // A player with a link and a coal mine, so placements, links and
+    // develops all have candidates
+    std::shared_ptr<Player> setupLegalMoveState(GameState &state)
+    {
+        auto player = state.addPlayer();
+        GameAction action;
+        action.type = GameAction::Type::PlaceLink;
+        action.city = state.m_board.getCityId("Birmingham");
+        action.city2 = state.m_board.getCityId("Coventry");
+        state.handleAction(player->id, action);
+        action.type = GameAction::Type::PlaceTile;
+        action.city = state.m_board.getCityId("Stone");
+        action.slotIndex = 1;
+        action.tileType = TileType::Coal;
+        state.handleAction(player->id, action);
+        return player;
+    }
+
+    std::tuple<GameAction::Type, CityId, CityId, int, TileType, TileType> key(const GameAction &action)
+    {
+        return {action.type, action.city, action.city2, action.slotIndex, action.tileType, action.tileType2};
+    }
+}
+
+TEST_F(GameStateTest, LegalActionsAreAccepted)
+{
+    auto player = setupLegalMoveState(gameState);
+    auto actions = gameState.getLegalActions(player->id);
+    ASSERT_FALSE(actions.empty());
+
+    std::set<GameAction::Type> kinds;
+    for (const auto &action : actions)
+    {
+        kinds.insert(action.type);
+        GameState fresh;
+        setupLegalMoveState(fresh);
+        EXPECT_TRUE(fresh.handleAction(player->id, action)) << gameState.getLegalMoves(player->id).dump();
+    }
+    EXPECT_EQ(kinds, (std::set<GameAction::Type>{GameAction::Type::PlaceTile, GameAction::Type::PlaceLink,
+                                                  GameAction::Type::Develop, GameAction::Type::TakeLoan}));
+    EXPECT_TRUE(gameState.getLegalActions(player->id + 1).empty());
+}
+
+TEST_F(GameStateTest, LegalActionsCoverAcceptedPlacementsAndLinks)
+{
+    auto player = setupLegalMoveState(gameState);
+    std::set<decltype(key(GameAction()))> legal;
+    for (const auto &action : gameState.getLegalActions(player->id))
+        legal.insert(key(action));
+
+    auto tryAction = [&](const GameAction &action)
+    {
+        GameState fresh;
+        setupLegalMoveState(fresh);
+        EXPECT_EQ(fresh.handleAction(player->id, action), legal.count(key(action)) > 0);
+    };
+
+    const TileType industries[] = {TileType::Coal, TileType::Iron, TileType::Cotton,
+                                   TileType::Manufacturer, TileType::Pottery, TileType::Brewery};
+    for (CityId cityId = 0; cityId < static_cast<CityId>(gameState.m_board.getCityCount()); cityId++)
+    {
+        const City *city = gameState.m_board.getCity(cityId);
+        if (!city)
+            continue;
+        for (size_t slot = 0; slot < city->slots.size(); slot++)
+        {
+            for (TileType type : industries)
+            {
+                GameAction action;
+                action.type = GameAction::Type::PlaceTile;
+                action.city = city->id;
+                action.slotIndex = static_cast<int>(slot);
+                action.tileType = type;
+                tryAction(action);
+            }
+        }
+    }
+    for (const auto &connection : gameState.m_board.getAllConnections())
+    {
+        GameAction action;
+        action.type = GameAction::Type::PlaceLink;
+        action.city = connection.city1;
+        action.city2 = connection.city2;
+        tryAction(action);
+    }
+}
+
+TEST_F(GameStateTest, LegalMovesMessage)
+{
+    auto player = gameState.addPlayer();
+    player->money = 0;
+    auto moves = gameState.getLegalMoves(player->id);
+    EXPECT_EQ(moves["type"], "legalMoves");
+    EXPECT_EQ(moves["seq"], gameState.getSequence());
+
+    // Broke, with no network yet: only the free links and the loan remain
+    std::set<std::string> names;
+    for (const auto &action : moves["actions"])
+        names.insert(action["action"].get<std::string>());
+    EXPECT_EQ(names, (std::set<std::string>{"placeLink", "takeLoan"}));
+    EXPECT_EQ(moves["actions"][0]["action"], "placeLink");
+    EXPECT_TRUE(moves["actions"][0].contains("cityName"));
+    EXPECT_TRUE(moves["actions"][0].contains("cityName2"));
+}
+
+TEST_F(GameStateTest, CopyIsIndependent)
+{
+    auto player = setupLegalMoveState(gameState);
+    gameState.takeDelta();
+    GameState copy = gameState;
+    EXPECT_EQ(copy.getState(), gameState.getState());
+
+    auto actions = copy.getLegalActions(player->id);
+    ASSERT_FALSE(actions.empty());
+    for (const auto &action : actions)
+    {
+        if (action.type == GameAction::Type::PlaceTile)
+        {
+            ASSERT_TRUE(copy.handleAction(player->id, action));
+            break;
+        }
+    }
+    GameAction loan;
+    loan.type = GameAction::Type::TakeLoan;
+    ASSERT_TRUE(copy.handleAction(player->id, loan));
+    copy.advanceEra();
+
+    EXPECT_NE(copy.getState(), gameState.getState());
+    EXPECT_EQ(player->income_level, 10);
+    EXPECT_EQ(gameState.getEra(), ERA::Canal);
+    EXPECT_FALSE(gameState.hasPendingChanges());
+    EXPECT_EQ(gameState.getLegalActions(player->id).size(), actions.size());
+
+    gameState = copy;
+    EXPECT_EQ(gameState.getState(), copy.getState());
+}
+
+TEST_F(GameStateTest, UndoRestoresEveryStep)
+{
+    std::vector<int> players;
+    for (int i = 0; i < 3; i++)
+        players.push_back(gameState.addPlayer()->id);
+    gameState.setUndoEnabled(true);
+
+    auto snapshot = [&]()
+    {
+        nlohmann::json state = gameState.getState();
+        state.erase("seq");
+        for (int player : players)
+        {
+            nlohmann::json legal = nlohmann::json::array();
+            for (const auto &action : gameState.getLegalActions(player))
+                legal.push_back({action.type, action.city, action.city2, action.slotIndex, action.tileType, action.tileType2});
+            state["legal"].push_back(legal);
+        }
+        for (TileType type : {TileType::Coal, TileType::Iron, TileType::Brewery, TileType::Merchant})
+        {
+            for (const auto &source : gameState.m_board.getResourceSlots(type))
+                state["resources"].push_back({type, source.city, source.slotIndex});
+            state["totals"].push_back(gameState.m_board.getResourceTotal(type));
+        }
+        return state;
+    };
+
+    std::mt19937 rng(3);
+    std::vector<nlohmann::json> history;
+    for (int turn = 0; turn < 60; turn++)
+    {
+        int player = players[turn % players.size()];
+        auto actions = gameState.getLegalActions(player);
+        if (actions.empty())
+            continue;
+        history.push_back(snapshot());
+        ASSERT_TRUE(gameState.handleAction(player, actions[rng() % actions.size()]));
+    }
+    ASSERT_EQ(gameState.getUndoDepth(), history.size());
+
+    while (!history.empty())
+    {
+        ASSERT_EQ(gameState.undo(), 1u);
+        EXPECT_EQ(snapshot(), history.back()) << "after undoing to step " << history.size();
+        history.pop_back();
+    }
+    EXPECT_EQ(gameState.undo(), 0u);
+}
+
+TEST_F(GameStateTest, UndoneLinkIsRemovedInDelta)
+{
+    auto player = gameState.addPlayer();
+    gameState.setUndoEnabled(true);
+
+    GameAction action;
+    action.type = GameAction::Type::PlaceLink;
+    action.city = id("Coventry");
+    action.city2 = id("Birmingham");
+    ASSERT_TRUE(gameState.handleAction(player->id, action));
+    gameState.takeDelta();
+
+    // Rejected actions are not recorded
+    EXPECT_FALSE(gameState.handleAction(player->id, action));
+    EXPECT_EQ(gameState.getUndoDepth(), 1u);
+
+    EXPECT_EQ(gameState.undo(2), 1u);
+    EXPECT_FALSE(gameState.m_board.areConnected(id("Coventry"), id("Birmingham")));
+    auto delta = gameState.takeDelta();
+    ASSERT_EQ(delta["removedConnections"].size(), 1u);
+    EXPECT_EQ(delta["removedConnections"][0]["city1"], "Birmingham");
+    EXPECT_EQ(delta["connections"].size(), 0u);
+
+    ASSERT_TRUE(gameState.handleAction(player->id, action));
+    gameState.advanceEra();
+    EXPECT_EQ(gameState.getUndoDepth(), 0u);
+}
+
+TEST_F(GameStateTest, JoinEmptiesUndoLog)
+{
+    auto player = gameState.addPlayer();
+    gameState.setUndoEnabled(true);
+
+    GameAction loan;
+    loan.type = GameAction::Type::TakeLoan;
+    ASSERT_TRUE(gameState.handleAction(player->id, loan));
+    ASSERT_EQ(gameState.getUndoDepth(), 1u);
+
+    gameState.addPlayer();
+    EXPECT_EQ(gameState.getUndoDepth(), 0u);
+    EXPECT_EQ(gameState.undo(), 0u);
+    EXPECT_EQ(player->income_level, 7);
+}
+
+TEST_F(GameStateTest, BoardEditsEmptyUndoLog)
+{
+    auto player = gameState.addPlayer();
+    gameState.setUndoEnabled(true);
+
+    GameAction link;
+    link.type = GameAction::Type::PlaceLink;
+    link.city = id("Coventry");
+    link.city2 = id("Birmingham");
+    ASSERT_TRUE(gameState.handleAction(player->id, link));
+
+    // A new connection shifts the connection indices the log refers to
+    gameState.m_board.addConnection("Birmingham", "Atlantis");
+    EXPECT_EQ(gameState.undo(), 0u);
+    EXPECT_TRUE(gameState.m_board.areConnected(id("Coventry"), id("Birmingham")));
+    EXPECT_EQ(gameState.getUndoDepth(), 0u);
+
+    // Replacing the board keeps recording
+    GameBoard board;
+    board.initializeBrassBirminghamMap();
+    gameState.setupBoardForTesting(board);
+    ASSERT_TRUE(gameState.handleAction(player->id, link));
+    EXPECT_EQ(gameState.undo(), 1u);
+    EXPECT_FALSE(gameState.m_board.areConnected(id("Coventry"), id("Birmingham")));
+}
+
+TEST_F(GameStateTest, DevelopNeedsTilesOnTheBoard)
+{
+    auto player = gameState.addPlayer();
+    auto develop = [](TileType type, TileType type2)
+    {
+        GameAction action;
+        action.type = GameAction::Type::Develop;
+        action.tileType = type;
+        action.tileType2 = type2;
+        return action;
+    };
+    auto generated = [&](TileType type, TileType type2)
+    {
+        for (const auto &action : gameState.getLegalActions(player->id))
+        {
+            if (action.type == GameAction::Type::Develop && action.tileType == type && action.tileType2 == type2)
+                return true;
+        }
+        return false;
+    };
+
+    // Leave one iron tile
+    ASSERT_TRUE(gameState.handleAction(player->id, develop(TileType::Iron, TileType::Iron)));
+    ASSERT_TRUE(gameState.handleAction(player->id, develop(TileType::Iron, TileType::NullTile)));
+    ASSERT_EQ(player->player_board.getRemainingTileAmount(TileType::Iron), 1u);
+    EXPECT_FALSE(generated(TileType::Iron, TileType::Iron));
+    EXPECT_FALSE(gameState.handleAction(player->id, develop(TileType::Iron, TileType::Iron)));
+    EXPECT_TRUE(generated(TileType::Iron, TileType::NullTile));
+
+    // And then none
+    ASSERT_TRUE(gameState.handleAction(player->id, develop(TileType::Iron, TileType::NullTile)));
+    EXPECT_FALSE(generated(TileType::Iron, TileType::NullTile));
+    EXPECT_FALSE(gameState.handleAction(player->id, develop(TileType::Iron, TileType::NullTile)));
+    EXPECT_FALSE(gameState.handleAction(player->id, develop(TileType::Coal, TileType::Iron)));
+    EXPECT_FALSE(gameState.handleAction(player->id, develop(TileType::Merchant, TileType::NullTile)));
+
+    for (const auto &action : gameState.getLegalActions(player->id))
+    {
+        GameState copy = gameState;
+        EXPECT_TRUE(copy.handleAction(player->id, action));
+    }
+}
@@ -36,10 +36,10 @@ TEST_F(IncomeFunctionsTest, TakeLoanAtHighLevel) {
 }
 
 TEST_F(IncomeFunctionsTest, TakeLoanAtLowLevel) {
-    EXPECT_EQ(takeLoan(5), 2);
-    EXPECT_EQ(takeLoan(10), 7);
-    EXPECT_EQ(takeLoan(11), 8);
-    EXPECT_EQ(takeLoan(12), 8);
+    EXPECT_EQ(takeLoan(5), 2u);
+    EXPECT_EQ(takeLoan(10), 7u);
+    EXPECT_EQ(takeLoan(11), 8u);
+    EXPECT_EQ(takeLoan(12), 8u);
 }
 
 TEST_F(IncomeFunctionsTest, GetIncomeOutOfRange) {
@@ -51,3 +51,30 @@ TEST_F(IncomeFunctionsTest, TakeLoanOutOfRange) {
     EXPECT_THROW(takeLoan(-1), std::out_of_range);
     EXPECT_THROW(takeLoan(100), std::out_of_range);
 }
+
+TEST_F(IncomeFunctionsTest, LevelForIncomeInvertsTable) {
+    for (int level = MIN_INCOME_LEVEL; level <= MAX_INCOME_LEVEL; ++level) {
+        int income = incomeFor(level);
+        EXPECT_LE(levelForIncome(income), level);
+        EXPECT_EQ(incomeFor(levelForIncome(income)), income);
+    }
+    EXPECT_EQ(levelForIncome(MIN_INCOME - 5), MIN_INCOME_LEVEL);
+    EXPECT_EQ(levelForIncome(MAX_INCOME + 5), levelForIncome(MAX_INCOME));
+    EXPECT_EQ(incomeFor(-1), MIN_INCOME);
+    EXPECT_EQ(incomeFor(100), MAX_INCOME);
+}
+
+TEST_F(IncomeFunctionsTest, LoanLevelWithoutThrowing) {
+    EXPECT_EQ(loanLevel(30), 24);
+    EXPECT_EQ(loanLevel(3), 0);
+    EXPECT_EQ(loanLevel(2), -1);
+    EXPECT_EQ(loanLevel(-1), -1);
+    EXPECT_EQ(loanLevel(100), -1);
+    EXPECT_THROW(takeLoan(2), std::out_of_range);
+}
+
+TEST_F(IncomeFunctionsTest, BatchMatchesSingleLookups) {
+    std::vector<int> levels = {10, 30, 90, 2, -1, 100};
+    EXPECT_EQ(getIncomes(levels), (std::vector<int>{0, 10, 28, -8, MIN_INCOME, MAX_INCOME}));
+    EXPECT_EQ(takeLoans(levels), (std::vector<int>{7, 24, 80, -1, -1, -1}));
+}
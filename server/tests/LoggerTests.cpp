@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "Logger.hpp"
+#include "RingBuffer.hpp"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+TEST(RingBufferTest, FifoUntilFull)
+{
+    RingBuffer<int> buffer(4);
+    ASSERT_EQ(buffer.capacity(), 4u);
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(buffer.tryPush(int(i)));
+    }
+    EXPECT_FALSE(buffer.tryPush(99));
+
+    int value = -1;
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(buffer.tryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(buffer.tryPop(value));
+}
+
+TEST(RingBufferTest, ConcurrentProducers)
+{
+    const int producers = 4;
+    const int perProducer = 1000;
+    RingBuffer<int> buffer(producers * perProducer);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&buffer, p]()
+                             {
+            for (int i = 0; i < perProducer; ++i)
+            {
+                ASSERT_TRUE(buffer.tryPush(p * perProducer + i));
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<bool> seen(producers * perProducer, false);
+    int value;
+    int count = 0;
+    while (buffer.tryPop(value))
+    {
+        EXPECT_FALSE(seen[value]);
+        seen[value] = true;
+        count++;
+    }
+    EXPECT_EQ(count, producers * perProducer);
+}
+
+TEST(LoggerTest, LevelFiltering)
+{
+    Logger &logger = Logger::instance();
+    LogLevel previous = logger.getLevel();
+
+    logger.setLevel(LogLevel::Warn);
+    EXPECT_FALSE(logger.isEnabled(LogLevel::Debug));
+    EXPECT_TRUE(logger.isEnabled(LogLevel::Error));
+
+    // Disabled statements must not evaluate their arguments
+    int evaluated = 0;
+    LOG_DEBUG("test", "value " << ++evaluated);
+    EXPECT_EQ(evaluated, 0);
+
+    logger.setLevel(previous);
+}
+
+TEST(LoggerTest, ParseAndFormat)
+{
+    LogLevel level;
+    ASSERT_TRUE(Logger::parseLevel("debug", level));
+    EXPECT_EQ(level, LogLevel::Debug);
+    EXPECT_FALSE(Logger::parseLevel("verbose", level));
+
+    Logger::Record record;
+    record.level = LogLevel::Info;
+    record.component = "ws";
+    record.message = "say \"hi\"\n";
+    std::string line = Logger::format(record);
+    EXPECT_NE(line.find("level=info component=ws"), std::string::npos);
+    EXPECT_NE(line.find("msg=\"say \\\"hi\\\"\\n\""), std::string::npos);
+}
+
+TEST(LoggerTest, StopFlushesQueuedRecords)
+{
+    Logger &logger = Logger::instance();
+    LogLevel previous = logger.getLevel();
+    logger.setLevel(LogLevel::Info);
+
+    std::ostringstream captured;
+    std::streambuf *original = std::cout.rdbuf(captured.rdbuf());
+    logger.start();
+    // Let the writer go idle so the records below arrive while it is parked
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    LOG_INFO("test", "first record");
+    LOG_INFO("test", "last record before stop");
+    logger.stop();
+    std::cout.rdbuf(original);
+    logger.setLevel(previous);
+
+    std::string output = captured.str();
+    EXPECT_NE(output.find("msg=\"first record\""), std::string::npos);
+    EXPECT_NE(output.find("msg=\"last record before stop\""), std::string::npos);
+}
+
+TEST(RingBufferTest, EmptyTracksContents)
+{
+    RingBuffer<int> buffer(2);
+    EXPECT_TRUE(buffer.empty());
+    buffer.tryPush(1);
+    EXPECT_FALSE(buffer.empty());
+    int value;
+    buffer.tryPop(value);
+    EXPECT_TRUE(buffer.empty());
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "../src/Market.hpp"
+#include <algorithm>
 #include <iostream>
 
 class MarketTest : public ::testing::Test {
@@ -90,4 +91,63 @@ TEST_F(MarketTest, GetPriceExceedingCapacity) {
     
     // Verify that the market state hasn't changed
     EXPECT_EQ(market->getPrice(1), 6);
-}
\ No newline at end of file
+}
+TEST_F(MarketTest, BatchQuotes) {
+    market->buy(4);
+    std::vector<int> prices = market->getPrices({0, 1, 2, 8, 20});
+    ASSERT_EQ(prices.size(), 5u);
+    EXPECT_EQ(prices[0], 0);
+    EXPECT_EQ(prices[1], 3);
+    EXPECT_EQ(prices[2], 3+3);
+    EXPECT_EQ(prices[3], 3+3+4+4+5+5+6+6);
+    EXPECT_EQ(prices[4], market->getPrice(20));
+    EXPECT_EQ(market->getCubeCount(), 10);
+}
+
+TEST_F(MarketTest, MatchesSlotBySlotTrack) {
+    // Reference track: cubes per price, bought cheapest first and sold
+    // into the most expensive empty slot
+    std::vector<int> track(7, 2);
+    auto referencePrice = [&](int quantity) {
+        std::vector<int> copy = track;
+        int cost = 0;
+        for (int n = 0; n < quantity; ++n) {
+            auto it = std::find_if(copy.begin(), copy.end(), [](int c) { return c > 0; });
+            if (it == copy.end()) {
+                cost += 8;
+            } else {
+                cost += static_cast<int>(it - copy.begin()) + 1;
+                --*it;
+            }
+        }
+        return cost;
+    };
+
+    const int ops[] = {3, -2, 5, 1, -4, 9, -14, 2, 7, -1, 20, -3};
+    for (int op : ops) {
+        for (int quantity = 0; quantity <= 16; ++quantity) {
+            ASSERT_EQ(market->getPrice(quantity), referencePrice(quantity));
+        }
+        if (op > 0) {
+            int expected = referencePrice(op);
+            for (int n = 0; n < op; ++n) {
+                auto it = std::find_if(track.begin(), track.end(), [](int c) { return c > 0; });
+                if (it != track.end()) --*it;
+            }
+            EXPECT_EQ(market->buy(op), expected);
+        } else {
+            int sold = 0, revenue = 0;
+            for (int n = 0; n < -op; ++n) {
+                auto it = std::find_if(track.rbegin(), track.rend(), [](int c) { return c < 2; });
+                if (it == track.rend()) break;
+                ++*it;
+                ++sold;
+                revenue += static_cast<int>(track.rend() - it);
+            }
+            EXPECT_EQ(market->sell(-op), std::make_pair(sold, revenue));
+        }
+        int total = 0;
+        for (int c : track) total += c;
+        EXPECT_EQ(market->getCubeCount(), total);
+    }
+}
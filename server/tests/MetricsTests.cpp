@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "Metrics.hpp"
+
+TEST(HistogramTest, BucketsAreLogLinear)
+{
+    EXPECT_EQ(Histogram::bucketIndex(0), 0u);
+    EXPECT_EQ(Histogram::bucketIndex(1024), 0u);
+    EXPECT_EQ(Histogram::bucketIndex(1025), 1u);
+    EXPECT_EQ(Histogram::upperBound(1), 1280u);
+    EXPECT_EQ(Histogram::bucketIndex(1280), 1u);
+    EXPECT_EQ(Histogram::bucketIndex(1281), 2u);
+    EXPECT_EQ(Histogram::bucketIndex(2048), 4u);
+    EXPECT_EQ(Histogram::upperBound(4), 2048u);
+    EXPECT_EQ(Histogram::bucketIndex(uint64_t(1) << 40), Histogram::BUCKET_COUNT - 1);
+
+    // Every value lands in a bucket whose bound is within 25% above it
+    for (uint64_t value = 1025; value < (uint64_t(1) << 30); value = value * 3 / 2)
+    {
+        uint64_t bound = Histogram::upperBound(Histogram::bucketIndex(value));
+        EXPECT_GE(bound, value);
+        EXPECT_LE(bound, value + value / 4 + 1);
+    }
+}
+
+TEST(HistogramTest, Percentiles)
+{
+    Histogram histogram;
+    EXPECT_EQ(histogram.percentile(0.5), 0u);
+
+    for (int i = 0; i < 99; ++i)
+    {
+        histogram.record(uint64_t(10000));
+    }
+    histogram.record(uint64_t(5000000));
+
+    EXPECT_EQ(histogram.count(), 100u);
+    EXPECT_EQ(histogram.sum(), 99u * 10000 + 5000000);
+    EXPECT_EQ(histogram.percentile(0.5), Histogram::upperBound(Histogram::bucketIndex(10000)));
+    EXPECT_EQ(histogram.percentile(1.0), Histogram::upperBound(Histogram::bucketIndex(5000000)));
+}
+
+TEST(MetricsTest, RendersPrometheusText)
+{
+    Metrics metrics;
+    metrics.connectionOpened();
+    metrics.connectionOpened();
+    metrics.connectionClosed();
+    metrics.messageIn(120);
+    metrics.messageOut(4000);
+    metrics.messageOut(4000);
+    metrics.actionHandled(GameAction::Type::PlaceTile, true);
+    metrics.actionHandled(GameAction::Type::PlaceTile, false);
+    metrics.actionHandled(GameAction::Type::Sell, false);
+    metrics.parseLatency().record(uint64_t(2000));
+
+    std::string text = metrics.prometheus();
+    EXPECT_NE(text.find("brass_connections 1\n"), std::string::npos);
+    EXPECT_NE(text.find("brass_connections_total 2\n"), std::string::npos);
+    EXPECT_NE(text.find("brass_messages_in_total 1\n"), std::string::npos);
+    EXPECT_NE(text.find("brass_bytes_out_total 8000\n"), std::string::npos);
+    EXPECT_NE(text.find("brass_actions_total{type=\"place_tile\",result=\"accepted\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("brass_actions_total{type=\"sell\",result=\"rejected\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE brass_parse_seconds histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("brass_parse_seconds_bucket{le=\"1.024e-06\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("brass_parse_seconds_bucket{le=\"+Inf\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("brass_parse_seconds_count 1\n"), std::string::npos);
+    EXPECT_NE(text.find("brass_broadcast_seconds_count 0\n"), std::string::npos);
+}
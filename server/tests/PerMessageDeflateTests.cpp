@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include "PerMessageDeflate.hpp"
+#include "GameState.hpp"
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct TestConfig
+    {
+        static DeflateSettingsSlot &settings()
+        {
+            static DeflateSettingsSlot slot;
+            return slot;
+        }
+    };
+    typedef PerMessageDeflate<TestConfig> Deflate;
+
+    class PerMessageDeflateTest : public ::testing::Test
+    {
+    protected:
+        // Client side of a connection: inflates what the server produced
+        static std::string inflateMessage(Deflate& client, const std::string& compressed)
+        {
+            std::string out;
+            std::string data = compressed + std::string("\x00\x00\xff\xff", 4);
+            EXPECT_FALSE(client.decompress(reinterpret_cast<const uint8_t*>(data.data()), data.size(), out));
+            return out;
+        }
+    };
+}
+
+TEST_F(PerMessageDeflateTest, NegotiatesConfiguredParameters)
+{
+    DeflateSettings settings;
+    settings.server_no_context_takeover = true;
+    settings.server_max_window_bits = 12;
+
+    Deflate deflate(settings);
+    auto result = deflate.negotiate({});
+    ASSERT_FALSE(result.first);
+    EXPECT_EQ(result.second, "permessage-deflate; server_no_context_takeover; server_max_window_bits=12");
+
+    // The client may ask for a smaller window but not a larger one
+    Deflate smaller(settings);
+    result = smaller.negotiate({{"server_max_window_bits", "10"}, {"client_max_window_bits", ""}});
+    ASSERT_FALSE(result.first);
+    EXPECT_EQ(result.second, "permessage-deflate; server_no_context_takeover; server_max_window_bits=10");
+}
+
+TEST_F(PerMessageDeflateTest, RejectsInvalidOffers)
+{
+    Deflate deflate;
+    EXPECT_TRUE(deflate.negotiate({{"unknown", ""}}).first);
+    EXPECT_TRUE(deflate.negotiate({{"server_max_window_bits", "8"}}).first);
+    EXPECT_TRUE(deflate.negotiate({{"server_no_context_takeover", "1"}}).first);
+
+    EXPECT_TRUE(deflate.is_implemented());
+    DeflateSettings disabled;
+    disabled.enabled = false;
+    EXPECT_FALSE(Deflate(disabled).is_implemented());
+}
+
+TEST_F(PerMessageDeflateTest, CompressesStateSnapshots)
+{
+    GameState gameState;
+    gameState.addPlayer();
+    std::string state = gameState.getState().dump();
+
+    Deflate server;
+    Deflate client;
+    ASSERT_FALSE(server.negotiate({}).first);
+    ASSERT_FALSE(server.init(true));
+    ASSERT_FALSE(client.init(true));
+
+    std::string compressed;
+    ASSERT_FALSE(server.compress(state, compressed));
+    EXPECT_LT(compressed.size() * 4, state.size());
+    EXPECT_EQ(inflateMessage(client, compressed), state);
+}
+
+TEST_F(PerMessageDeflateTest, ContextTakeoverIsConfigurable)
+{
+    std::string message(2000, 'x');
+    for (size_t i = 0; i < message.size(); i += 7)
+    {
+        message[i] = static_cast<char>('a' + (i * 31) % 26);
+    }
+
+    // With context takeover a repeated message refers back to the previous one
+    Deflate takeover;
+    Deflate client;
+    ASSERT_FALSE(takeover.negotiate({}).first);
+    ASSERT_FALSE(takeover.init(true));
+    ASSERT_FALSE(client.init(true));
+    std::string first, second;
+    ASSERT_FALSE(takeover.compress(message, first));
+    ASSERT_FALSE(takeover.compress(message, second));
+    EXPECT_LT(second.size(), first.size());
+    EXPECT_EQ(inflateMessage(client, first), message);
+    EXPECT_EQ(inflateMessage(client, second), message);
+
+    DeflateSettings settings;
+    settings.server_no_context_takeover = true;
+    Deflate reset(settings);
+    ASSERT_FALSE(reset.negotiate({}).first);
+    ASSERT_FALSE(reset.init(true));
+    std::string third, fourth;
+    ASSERT_FALSE(reset.compress(message, third));
+    ASSERT_FALSE(reset.compress(message, fourth));
+    EXPECT_EQ(third, fourth);
+}
+
+TEST_F(PerMessageDeflateTest, ConfigSettingsArePublishedOnce)
+{
+    // Before anything is published extensions start from the defaults
+    EXPECT_EQ(Deflate().negotiate({}).second, "permessage-deflate");
+
+    DeflateSettings settings;
+    settings.server_max_window_bits = 11;
+    ASSERT_TRUE(TestConfig::settings().publish(settings));
+    EXPECT_EQ(Deflate().negotiate({}).second, "permessage-deflate; server_max_window_bits=11");
+
+    // Publishing the same settings again is harmless, different ones are refused
+    EXPECT_TRUE(TestConfig::settings().publish(settings));
+    DeflateSettings other;
+    other.level = 1;
+    EXPECT_FALSE(TestConfig::settings().publish(other));
+    EXPECT_EQ(TestConfig::settings().get(), settings);
+}
+
+TEST_F(PerMessageDeflateTest, InflatesWhileCompressing)
+{
+    // Reads and writes on one connection run on different io threads
+    // Barely compressible payloads keep both sides busy in the output buffer
+    const int rounds = 200;
+    std::string inbound(64 * 1024, ' ');
+    std::string outbound(64 * 1024, ' ');
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < inbound.size(); ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        inbound[i] = static_cast<char>(seed >> 24);
+        outbound[i] = static_cast<char>(seed >> 16);
+    }
+
+    Deflate server;
+    Deflate clientSender;
+    Deflate clientReceiver;
+    ASSERT_FALSE(server.negotiate({}).first);
+    ASSERT_FALSE(server.init(true));
+    ASSERT_FALSE(clientSender.init(true));
+    ASSERT_FALSE(clientReceiver.init(true));
+
+    std::vector<std::string> frames(rounds);
+    for (auto &frame : frames)
+    {
+        ASSERT_FALSE(clientSender.compress(inbound, frame));
+        frame += std::string("\x00\x00\xff\xff", 4);
+    }
+
+    int badReads = 0;
+    std::thread reader([&]()
+                       {
+        for (const auto &frame : frames)
+        {
+            std::string out;
+            if (server.decompress(reinterpret_cast<const uint8_t *>(frame.data()), frame.size(), out) || out != inbound)
+            {
+                badReads++;
+            }
+        } });
+
+    int badWrites = 0;
+    for (int i = 0; i < rounds; ++i)
+    {
+        std::string compressed;
+        ASSERT_FALSE(server.compress(outbound, compressed));
+        if (inflateMessage(clientReceiver, compressed) != outbound)
+        {
+            badWrites++;
+        }
+    }
+    reader.join();
+    EXPECT_EQ(badReads, 0);
+    EXPECT_EQ(badWrites, 0);
+}
@@ -31,24 +31,24 @@ TEST_F(PlayerBoardTest, InitializationTest) {
 TEST_F(PlayerBoardTest, PeekTileTest) {
     // Check if peeking returns the correct tile type and level
     auto coalTile = board->peekTile(TileType::Coal);
-    EXPECT_EQ(coalTile->type, TileType::Coal);
-    EXPECT_EQ(coalTile->level, 1);
+    EXPECT_EQ(coalTile.type, TileType::Coal);
+    EXPECT_EQ(coalTile.level, 1);
 
     auto ironTile = board->peekTile(TileType::Iron);
-    EXPECT_EQ(ironTile->type, TileType::Iron);
-    EXPECT_EQ(ironTile->level, 1);
+    EXPECT_EQ(ironTile.type, TileType::Iron);
+    EXPECT_EQ(ironTile.level, 1);
 }
 
 TEST_F(PlayerBoardTest, TakeTileTest) {
     // Take a tile and check if it's removed from the board
     auto coalTile = board->takeTile(TileType::Coal);
-    EXPECT_EQ(coalTile->type, TileType::Coal);
-    EXPECT_EQ(coalTile->level, 1);
+    EXPECT_EQ(coalTile.type, TileType::Coal);
+    EXPECT_EQ(coalTile.level, 1);
 
     // The next coal tile should be level 2
     auto nextCoalTile = board->peekTile(TileType::Coal);
-    EXPECT_EQ(nextCoalTile->type, TileType::Coal);
-    EXPECT_EQ(nextCoalTile->level, 2);
+    EXPECT_EQ(nextCoalTile.type, TileType::Coal);
+    EXPECT_EQ(nextCoalTile.level, 2);
 }
 
 TEST_F(PlayerBoardTest, HasTilesTest) {
@@ -63,4 +63,27 @@ TEST_F(PlayerBoardTest, HasTilesTest) {
     // Check if hasTiles returns false for depleted tiles
     EXPECT_EQ(coal_tile_count, 7);
     EXPECT_FALSE(board->hasTiles(TileType::Coal));
-}
\ No newline at end of file
+}
+
+TEST_F(PlayerBoardTest, DescriptorMatchesCatalog) {
+    auto manufacturer = board->peekTile(TileType::Manufacturer);
+    ASSERT_TRUE(static_cast<bool>(manufacturer));
+    EXPECT_EQ(manufacturer.owner, 1);
+    EXPECT_EQ(manufacturer.stats, TileCatalog::find(TileType::Manufacturer, 1));
+
+    Tile tile = manufacturer.makeTile();
+    EXPECT_EQ(tile.type, TileType::Manufacturer);
+    EXPECT_EQ(tile.owner, 1);
+    EXPECT_EQ(tile.cost_money, manufacturer.stats->cost_money);
+
+    EXPECT_FALSE(static_cast<bool>(board->peekTile(TileType::Merchant)));
+    EXPECT_EQ(board->getRemainingTileAmount(TileType::Merchant), 0u);
+}
+
+TEST_F(PlayerBoardTest, CopiesAreIndependent) {
+    PlayerBoard copy = *board;
+    copy.takeTile(TileType::Iron);
+    EXPECT_EQ(board->getRemainingTileAmount(TileType::Iron), 4u);
+    EXPECT_EQ(copy.getRemainingTileAmount(TileType::Iron), 3u);
+    EXPECT_EQ(copy.peekTile(TileType::Iron).level, 2);
+}
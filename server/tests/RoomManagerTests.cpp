@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "RoomManager.hpp"
+#include <thread>
+#include <vector>
+
+TEST(RoomManagerTest, RoomIdFromResource)
+{
+    std::string roomId;
+    ASSERT_TRUE(RoomManager::roomIdFromResource("/", roomId));
+    EXPECT_EQ(roomId, RoomManager::DEFAULT_ROOM);
+    ASSERT_TRUE(RoomManager::roomIdFromResource("/table-7", roomId));
+    EXPECT_EQ(roomId, "table-7");
+    ASSERT_TRUE(RoomManager::roomIdFromResource("/rooms/abc_1/?spectate=1", roomId));
+    EXPECT_EQ(roomId, "abc_1");
+
+    EXPECT_FALSE(RoomManager::roomIdFromResource("/a/b", roomId));
+    EXPECT_FALSE(RoomManager::roomIdFromResource("/" + std::string(65, 'x'), roomId));
+}
+
+TEST(RoomManagerTest, RoomsAreIndependent)
+{
+    websocketpp::lib::asio::io_service io;
+    RoomManager rooms(io);
+    auto a = rooms.acquire("a");
+    auto b = rooms.acquire("b");
+    ASSERT_NE(a, b);
+    EXPECT_EQ(rooms.roomCount(), 2u);
+
+    a->post([&]() { a->state().addPlayer(); });
+    io.run();
+    EXPECT_EQ(a->state().getState()["players"].size(), 1u);
+    EXPECT_EQ(b->state().getState()["players"].size(), 0u);
+
+    EXPECT_EQ(rooms.acquire("a"), a);
+}
+
+TEST(RoomManagerTest, EmptyRoomsAreReleased)
+{
+    websocketpp::lib::asio::io_service io;
+    RoomManager rooms(io);
+    auto first = rooms.acquire("a");
+    auto second = rooms.acquire("a");
+    rooms.release(first);
+    EXPECT_EQ(rooms.roomCount(), 1u);
+    rooms.release(second);
+    EXPECT_EQ(rooms.roomCount(), 0u);
+}
+
+TEST(RoomManagerTest, TasksInOneRoomAreSerialized)
+{
+    websocketpp::lib::asio::io_service io;
+    RoomManager rooms(io);
+    auto room = rooms.acquire("a");
+
+    const int tasks = 1000;
+    int counter = 0;
+    for (int i = 0; i < tasks; ++i)
+    {
+        room->post([&counter]() { counter++; });
+    }
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < 4; ++i)
+    {
+        pool.emplace_back([&io]() { io.run(); });
+    }
+    for (auto &thread : pool)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(counter, tasks);
+}
+
+TEST(RoomManagerTest, RoomLimit)
+{
+    websocketpp::lib::asio::io_service io;
+    RoomManager rooms(io, 1);
+    auto a = rooms.acquire("a");
+    EXPECT_EQ(rooms.acquire("b"), nullptr);
+    EXPECT_EQ(rooms.acquire("a"), a);
+}
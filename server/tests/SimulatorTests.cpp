@@ -0,0 +1,48 @@
+#include "Simulator.hpp"
+#include <gtest/gtest.h>
+
+TEST(SimulatorTest, SameSeedPlaysSameGame) {
+    SimOptions options;
+    options.policy = SimPolicy::Random;
+    SimStats first = playGame(7, options);
+    SimStats second = playGame(7, options);
+    EXPECT_EQ(first.accepted, second.accepted);
+    EXPECT_EQ(first.rejected, second.rejected);
+    EXPECT_EQ(first.passes, second.passes);
+}
+
+TEST(SimulatorTest, HeuristicPlayersOnlyTakeLegalActions) {
+    SimOptions options;
+    options.games = 4;
+    options.threads = 1;
+    SimStats stats = runSimulation(options);
+    EXPECT_EQ(stats.games, 4u);
+    EXPECT_GT(stats.actions(), 0u);
+    EXPECT_EQ(stats.rejections(), 0u);
+    EXPECT_TRUE(stats.failed_seeds.empty());
+}
+
+TEST(SimulatorTest, RandomPlayersAreRejected) {
+    SimOptions options;
+    options.games = 4;
+    options.threads = 1;
+    options.policy = SimPolicy::Random;
+    SimStats stats = runSimulation(options);
+    EXPECT_GT(stats.actions(), 0u);
+    EXPECT_GT(stats.rejections(), 0u);
+    EXPECT_TRUE(stats.failed_seeds.empty());
+}
+
+TEST(SimulatorTest, ThreadsDoNotChangeTotals) {
+    SimOptions options;
+    options.games = 8;
+    options.policy = SimPolicy::Random;
+    options.threads = 1;
+    SimStats serial = runSimulation(options);
+    options.threads = 4;
+    SimStats parallel = runSimulation(options);
+    EXPECT_EQ(parallel.games, serial.games);
+    EXPECT_EQ(parallel.accepted, serial.accepted);
+    EXPECT_EQ(parallel.rejected, serial.rejected);
+    EXPECT_EQ(parallel.passes, serial.passes);
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include "TileCatalog.hpp"
+#include "TileFactory.hpp"
+#include <stdexcept>
+
+TEST(TileCatalogTest, FactoryCopiesCatalogStats) {
+    const TileType types[] = {TileType::Coal, TileType::Iron, TileType::Cotton,
+                              TileType::Manufacturer, TileType::Pottery, TileType::Brewery};
+    for (TileType type : types) {
+        TileLevels levels = TileCatalog::levelsOf(type);
+        for (int level = 1; level <= levels.count; level++) {
+            const TileStats* stats = TileCatalog::find(type, level);
+            ASSERT_NE(stats, nullptr);
+            Tile tile = TileFactory::createTile(type, level, 3);
+            EXPECT_EQ(tile.type, type);
+            EXPECT_EQ(tile.level, level);
+            EXPECT_EQ(tile.owner, 3);
+            EXPECT_FALSE(tile.flipped);
+            EXPECT_EQ(tile.income, stats->income);
+            EXPECT_EQ(tile.victory_points, stats->victory_points);
+            EXPECT_EQ(tile.link_points, stats->link_points);
+            EXPECT_EQ(tile.cost_money, stats->cost_money);
+            EXPECT_EQ(tile.cost_coal, stats->cost_coal);
+            EXPECT_EQ(tile.cost_iron, stats->cost_iron);
+            EXPECT_EQ(tile.resource_amount, stats->resource_amount);
+            EXPECT_EQ(tile.beer_demand, stats->beer_demand);
+        }
+    }
+}
+
+TEST(TileCatalogTest, KnownEntries) {
+    static_assert(TileCatalog::find(TileType::Iron, 4)->resource_amount == 6, "iron IV holds 6 cubes");
+    EXPECT_EQ(TileCatalog::find(TileType::Pottery, 3)->beer_demand, 2);
+    EXPECT_EQ(TileCatalog::find(TileType::Manufacturer, 8)->cost_iron, 2);
+    EXPECT_EQ(TileCatalog::find(TileType::Coal, 5), nullptr);
+    EXPECT_EQ(TileCatalog::find(TileType::Brewery, 0), nullptr);
+}
+
+TEST(TileCatalogTest, InvalidTilesThrow) {
+    EXPECT_THROW(TileFactory::createTile(TileType::Coal, 5, 1), std::invalid_argument);
+    EXPECT_THROW(TileFactory::createTile(TileType::Manufacturer, 0, 1), std::invalid_argument);
+    EXPECT_THROW(TileFactory::createTile(TileType::Merchant, 1, 1), std::invalid_argument);
+}
@@ -13,6 +13,11 @@ protected:
     std::shared_ptr<Player> player1;
     std::shared_ptr<Player> player2;
 
+    CityId id(const std::string &name) const
+    {
+        return gameState.m_board.getCityId(name);
+    }
+
     void SetUp() override
     {
         player1 = gameState.addPlayer();
@@ -24,17 +29,17 @@ protected:
     void setupTestBoard()
     {
         auto coalTileA = TileFactory::createTile(TileType::Coal, 1, player1->id);
-        gameState.m_board.placeTile("Coventry", 1, coalTileA);
+        gameState.m_board.placeTile(id("Coventry"), 1, coalTileA);
 
         auto ironTileB = TileFactory::createTile(TileType::Iron, 1, player2->id);
-        gameState.m_board.placeTile("Coalbrookdale", 1, ironTileB);
+        gameState.m_board.placeTile(id("Coalbrookdale"), 1, ironTileB);
 
         auto coalTileC = TileFactory::createTile(TileType::Coal, 1, player2->id);
-        gameState.m_board.placeTile("Dudley", 0, coalTileC);
+        gameState.m_board.placeTile(id("Dudley"), 0, coalTileC);
 
         // Place link tiles
-        gameState.m_board.placeLink("Coventry", "Birmingham", player1);
-        gameState.m_board.placeLink("Birmingham", "Walsall", player2);
+        gameState.m_board.placeLink(id("Coventry"), id("Birmingham"), player1->id);
+        gameState.m_board.placeLink(id("Birmingham"), id("Walsall"), player2->id);
     }
 };
 
@@ -43,7 +48,7 @@ TEST_F(TilePlacementTest, PlaceTileTestResourceConsumption)
     setupTestBoard();
     GameAction placeAction;
     placeAction.type = GameAction::Type::PlaceTile;
-    placeAction.cityName = "Birmingham";
+    placeAction.city = id("Birmingham");
     placeAction.slotIndex = 1;
     placeAction.tileType = TileType::Manufacturer;
 
@@ -74,13 +79,13 @@ TEST_F(TilePlacementTest, PlaceTileTestResourceConsumption)
     EXPECT_EQ(state["board"]["cities"]["Birmingham"]["slots"][3]["placedTile"]["type"], TileType::Manufacturer);
     EXPECT_EQ(state["players"][0]["income_level"], 14);
 
-    placeAction.cityName = "Coventry";
+    placeAction.city = id("Coventry");
     placeAction.tileType = TileType::Iron;
     placeAction.slotIndex = 2;
     result = gameState.handleAction(player1->id, placeAction);
     ASSERT_FALSE(result); // cant access dudley coal
 
-    placeAction.cityName = "Walsall";
+    placeAction.city = id("Walsall");
     placeAction.slotIndex = 1;
     placeAction.tileType = TileType::Brewery;
     result = gameState.handleAction(player1->id, placeAction);
@@ -95,7 +100,7 @@ TEST_F(TilePlacementTest, TileNotConsumedFromOnFailedAction)
 {
     GameAction placeAction;
     placeAction.type = GameAction::Type::PlaceTile;
-    placeAction.cityName = "Leek";
+    placeAction.city = id("Leek");
     placeAction.slotIndex = 0;
     placeAction.tileType = TileType::Manufacturer;
     bool result = gameState.handleAction(player1->id, placeAction);
@@ -103,3 +108,24 @@ TEST_F(TilePlacementTest, TileNotConsumedFromOnFailedAction)
     result = gameState.handleAction(player1->id, placeAction);
     ASSERT_FALSE(result);
 }
+
+TEST_F(TilePlacementTest, IronIsTakenInBoardOrder)
+{
+    // Placed out of board order, the index alone would hand out Coalbrookdale's
+    auto ironLater = TileFactory::createTile(TileType::Iron, 1, player2->id);
+    ASSERT_TRUE(gameState.m_board.placeTile(id("Coalbrookdale"), 1, ironLater));
+    auto ironEarlier = TileFactory::createTile(TileType::Iron, 1, player1->id);
+    ASSERT_TRUE(gameState.m_board.placeTile(id("Birmingham"), 2, ironEarlier));
+    ASSERT_LT(id("Birmingham"), id("Coalbrookdale"));
+
+    GameAction placeAction;
+    placeAction.type = GameAction::Type::PlaceTile;
+    placeAction.city = id("Walsall");
+    placeAction.slotIndex = 1;
+    placeAction.tileType = TileType::Brewery;
+    ASSERT_TRUE(gameState.handleAction(player1->id, placeAction));
+
+    auto state = gameState.getState();
+    EXPECT_EQ(state["board"]["cities"]["Birmingham"]["slots"][2]["placedTile"]["resource_amount"], 3);
+    EXPECT_EQ(state["board"]["cities"]["Coalbrookdale"]["slots"][1]["placedTile"]["resource_amount"], 4);
+}
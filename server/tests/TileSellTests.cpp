@@ -13,6 +13,11 @@ protected:
     std::shared_ptr<Player> player1;
     std::shared_ptr<Player> player2;
 
+    CityId id(const std::string &name) const
+    {
+        return gameState.m_board.getCityId(name);
+    }
+
     void SetUp() override
     {
         player1 = gameState.addPlayer();
@@ -24,21 +29,21 @@ protected:
     void setupTestBoard()
     {
         auto manufacturerTileA = TileFactory::createTile(TileType::Manufacturer, 1, player1->id);
-        gameState.m_board.placeTile("Coventry", 1, manufacturerTileA);
+        gameState.m_board.placeTile(id("Coventry"), 1, manufacturerTileA);
 
         auto manufacturerTileB = TileFactory::createTile(TileType::Manufacturer, 2, player2->id);
-        gameState.m_board.placeTile("Stafford", 0, manufacturerTileB);
+        gameState.m_board.placeTile(id("Stafford"), 0, manufacturerTileB);
 
         auto breweryTile = TileFactory::createTile(TileType::Brewery, 1, player1->id);
-        gameState.m_board.placeTile("Walsall", 1, breweryTile);
+        gameState.m_board.placeTile(id("Walsall"), 1, breweryTile);
         // Place link tiles
-        gameState.m_board.placeLink("Coventry", "Birmingham", player1);
-        gameState.m_board.placeLink("Birmingham", "Walsall", player2);
-        gameState.m_board.placeLink("Birmingham", "Oxford", player1);
+        gameState.m_board.placeLink(id("Coventry"), id("Birmingham"), player1->id);
+        gameState.m_board.placeLink(id("Birmingham"), id("Walsall"), player2->id);
+        gameState.m_board.placeLink(id("Birmingham"), id("Oxford"), player1->id);
 
         // Place Merchant tiles
-        gameState.m_board.placeTile("Oxford", 0, MerchantTile(MerchantType::Manufacturer));
-        gameState.m_board.placeTile("Oxford", 1, MerchantTile(MerchantType::Empty));
+        gameState.m_board.placeTile(id("Oxford"), 0, MerchantTile(MerchantType::Manufacturer));
+        gameState.m_board.placeTile(id("Oxford"), 1, MerchantTile(MerchantType::Empty));
     }
 };
 
@@ -48,10 +53,10 @@ TEST_F(TileSellTest, SellTile)
     setupTestBoard();
     GameAction sellAction;
     sellAction.type = GameAction::Type::Sell;
-    sellAction.cityName = "Coventry";
+    sellAction.city = id("Coventry");
     sellAction.slotIndex = 1;
 
-    auto merchan_city = gameState.m_board.getMerchantCity("Oxford");
+    auto merchan_city = gameState.m_board.getMerchantCity(id("Oxford"));
     // merchan_city->slots[0].placedTile->resource_amount = 1;
     //  Get initial resource amounts
 
@@ -66,3 +71,86 @@ TEST_F(TileSellTest, SellTile)
     EXPECT_EQ(state["board"]["cities"]["Coventry"]["slots"][1]["placedTile"]["flipped"], true);
     EXPECT_EQ(state["board"]["cities"]["Walsall"]["slots"][1]["placedTile"]["resource_amount"], 0);
 }
+
+TEST_F(TileSellTest, SellConsumesMerchantBeer)
+{
+    auto manufacturerTile = TileFactory::createTile(TileType::Manufacturer, 1, player1->id);
+    ASSERT_TRUE(gameState.m_board.placeTile(id("Coventry"), 1, manufacturerTile));
+    gameState.m_board.placeLink(id("Coventry"), id("Birmingham"), player1->id);
+    gameState.m_board.placeLink(id("Birmingham"), id("Oxford"), player1->id);
+
+    MerchantTile merchantTile(MerchantType::Manufacturer);
+    merchantTile.resource_amount = 1;
+    ASSERT_TRUE(gameState.m_board.placeTile(id("Oxford"), 0, merchantTile));
+    gameState.takeDelta();
+
+    GameAction sellAction;
+    sellAction.type = GameAction::Type::Sell;
+    sellAction.city = id("Coventry");
+    sellAction.slotIndex = 1;
+    ASSERT_TRUE(gameState.handleAction(player1->id, sellAction));
+
+    auto state = gameState.getState();
+    EXPECT_EQ(state["board"]["cities"]["Coventry"]["slots"][1]["placedTile"]["flipped"], true);
+    EXPECT_EQ(state["board"]["cities"]["Oxford"]["slots"][0]["placedTile"]["resource_amount"], 0);
+    EXPECT_TRUE(gameState.m_board.getResourceSlots(TileType::Merchant).empty());
+
+    auto delta = gameState.takeDelta();
+    EXPECT_EQ(delta["slots"].size(), 2u);
+}
+
+TEST_F(TileSellTest, UndoSell)
+{
+    setupTestBoard();
+    gameState.setUndoEnabled(true);
+    auto before = gameState.getState();
+    int incomeBefore = player1->income_level;
+
+    GameAction sellAction;
+    sellAction.type = GameAction::Type::Sell;
+    sellAction.city = id("Coventry");
+    sellAction.slotIndex = 1;
+    ASSERT_TRUE(gameState.handleAction(player1->id, sellAction));
+    EXPECT_NE(player1->income_level, incomeBefore);
+    gameState.takeDelta();
+
+    EXPECT_EQ(gameState.undo(), 1u);
+    EXPECT_EQ(player1->income_level, incomeBefore);
+    EXPECT_EQ(gameState.m_board.getResourceTotal(TileType::Brewery), 1);
+    auto delta = gameState.takeDelta();
+    EXPECT_EQ(delta["slots"].size(), 2u);
+    EXPECT_EQ(delta["players"].size(), 1u);
+
+    auto after = gameState.getState();
+    after["seq"] = before["seq"];
+    EXPECT_EQ(after, before);
+    EXPECT_TRUE(gameState.handleAction(player1->id, sellAction));
+}
+
+TEST_F(TileSellTest, SellTakesClosestBeerFirst)
+{
+    auto manufacturerTile = TileFactory::createTile(TileType::Manufacturer, 1, player1->id);
+    ASSERT_TRUE(gameState.m_board.placeTile(id("Coventry"), 1, manufacturerTile));
+    gameState.m_board.placeLink(id("Coventry"), id("Birmingham"), player1->id);
+    gameState.m_board.placeLink(id("Birmingham"), id("Walsall"), player1->id);
+    gameState.m_board.placeLink(id("Birmingham"), id("Oxford"), player1->id);
+    gameState.m_board.placeLink(id("Birmingham"), id("Tamworth"), player1->id);
+    gameState.m_board.placeLink(id("Tamworth"), id("Nuneaton"), player1->id);
+    gameState.m_board.placeTile(id("Oxford"), 0, MerchantTile(MerchantType::Manufacturer));
+
+    // The farther brewery is placed first
+    auto farBrewery = TileFactory::createTile(TileType::Brewery, 1, player1->id);
+    ASSERT_TRUE(gameState.m_board.placeTile(id("Nuneaton"), 1, farBrewery));
+    auto nearBrewery = TileFactory::createTile(TileType::Brewery, 1, player2->id);
+    ASSERT_TRUE(gameState.m_board.placeTile(id("Walsall"), 1, nearBrewery));
+
+    GameAction sellAction;
+    sellAction.type = GameAction::Type::Sell;
+    sellAction.city = id("Coventry");
+    sellAction.slotIndex = 1;
+    ASSERT_TRUE(gameState.handleAction(player1->id, sellAction));
+
+    auto state = gameState.getState();
+    EXPECT_EQ(state["board"]["cities"]["Walsall"]["slots"][1]["placedTile"]["flipped"], true);
+    EXPECT_EQ(state["board"]["cities"]["Nuneaton"]["slots"][1]["placedTile"]["resource_amount"], 1);
+}
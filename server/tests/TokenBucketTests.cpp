@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include "TokenBucket.hpp"
+
+using namespace std::chrono;
+
+TEST(TokenBucketTest, AllowsBurstThenRefills)
+{
+    auto now = TokenBucket::clock::now();
+    TokenBucket bucket(10, 5, now);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        EXPECT_TRUE(bucket.tryConsume(1, now));
+    }
+    EXPECT_FALSE(bucket.tryConsume(1, now));
+
+    // 10 tokens per second, so 100ms buys one more message
+    EXPECT_TRUE(bucket.tryConsume(1, now + milliseconds(100)));
+    EXPECT_FALSE(bucket.tryConsume(1, now + milliseconds(100)));
+
+    // Refill is capped at the burst size
+    EXPECT_DOUBLE_EQ(bucket.available(now + seconds(10)), 5);
+}
+
+TEST(TokenBucketTest, OversizedRequestsNeedAFullBucket)
+{
+    auto now = TokenBucket::clock::now();
+    TokenBucket bucket(1000, 4000, now);
+
+    EXPECT_TRUE(bucket.tryConsume(10000, now));
+    EXPECT_FALSE(bucket.tryConsume(10000, now + milliseconds(500)));
+    EXPECT_TRUE(bucket.tryConsume(10000, now + milliseconds(4000)));
+}
+
+TEST(TokenBucketTest, ZeroRateIsUnlimited)
+{
+    TokenBucket bucket;
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_TRUE(bucket.tryConsume(1e9));
+    }
+}
@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include "WireProtocol.hpp"
+#include "GameState.hpp"
+
+TEST(WireProtocolTest, NegotiatesFirstSupportedSubprotocol)
+{
+    std::string selected;
+    EXPECT_FALSE(WireProtocol::negotiate({}, selected));
+    EXPECT_FALSE(WireProtocol::negotiate({"chat", "v2.example"}, selected));
+
+    ASSERT_TRUE(WireProtocol::negotiate({"chat", "brass.msgpack", "brass.cbor"}, selected));
+    EXPECT_EQ(selected, "brass.msgpack");
+    EXPECT_EQ(WireProtocol::fromSubprotocol(selected), WireFormat::MessagePack);
+    EXPECT_EQ(WireProtocol::fromSubprotocol("brass.cbor"), WireFormat::Cbor);
+    EXPECT_EQ(WireProtocol::fromSubprotocol(""), WireFormat::Json);
+}
+
+TEST(WireProtocolTest, RoundTripsGameState)
+{
+    GameState gameState;
+    gameState.addPlayer();
+    nlohmann::json state = gameState.getState();
+
+    for (WireFormat format : {WireFormat::Json, WireFormat::Cbor, WireFormat::MessagePack})
+    {
+        std::string encoded = WireProtocol::encode(state, format);
+        EXPECT_EQ(WireProtocol::decode(encoded, format), state);
+    }
+
+    // Binary encodings should be noticeably smaller than the JSON text
+    EXPECT_LT(WireProtocol::encode(state, WireFormat::Cbor).size(), state.dump().size());
+    EXPECT_LT(WireProtocol::encode(state, WireFormat::MessagePack).size(), state.dump().size());
+}
+
+TEST(WireProtocolTest, MalformedBinaryThrows)
+{
+    EXPECT_THROW(WireProtocol::decode(std::string("\xff\x00", 2), WireFormat::Cbor), nlohmann::json::exception);
+    EXPECT_THROW(WireProtocol::decode("{", WireFormat::Json), nlohmann::json::exception);
+}